@@ -67,6 +67,8 @@ Application::Application(char *infile) {
         addressOfMemberNode = (Address *) en->ENinit(addressOfMemberNode, par->PORTNUM);
         mp1[i] = new MP1Node(memberNode, par, en, log, addressOfMemberNode);
         mp2[i] = new MP2Node(memberNode, par, en1, log, addressOfMemberNode);
+        mp1[i]->subscribe(mp2[i]);
+        mp2[i]->setPiggyback(mp1[i]);
         log->LOG(&(mp1[i]->getMemberNode()->addr), "APP");
         log->LOG(&(mp2[i]->getMemberNode()->addr), "APP MP2");
         delete addressOfMemberNode;
@@ -97,6 +99,7 @@ Application::~Application() {
 int Application::run() {
     int i;
     int timeWhenAllNodesHaveJoined = 0;
+    int timeWhenMembershipConverged = -1;
     // boolean indicating if all nodes have joined
     bool allNodesJoined = false;
     srand(time(NULL));
@@ -111,14 +114,34 @@ int Application::run() {
             timeWhenAllNodesHaveJoined = par->getcurrtime();
             allNodesJoined = true;
         }
+        if (timeWhenMembershipConverged < 0 && membershipConverged()) {
+            timeWhenMembershipConverged = par->getcurrtime();
+        }
         if (par->getcurrtime() > timeWhenAllNodesHaveJoined + 50) {
             // Call the KV store functionalities
             mp2Run();
         }
         // Fail some nodes
         //fail();
+        // Decommission some nodes
+        leave();
+        // Bring the nodes down back
+        restart();
     }
 
+    log->LOG(&mp1[0]->getMemberNode()->addr, "#STATSLOG# %d nodes, %d seeds: membership converged at time %d",
+             par->EN_GPSZ, par->JOIN_SEEDS, timeWhenMembershipConverged);
+    en->ENlogTraffic(log, &mp1[0]->getMemberNode()->addr, "membership");
+    en1->ENlogTraffic(log, &mp1[0]->getMemberNode()->addr, "key-value");
+    logOpLatencies();
+    logStoreUsage();
+    logLoadSkew();
+    logPlacementCost();
+    logTransferStats();
+    logAntiEntropyStats();
+    logFilterStats();
+    logRebalanceStats();
+
     // Clean up
     en->ENcleanup();
     en1->ENcleanup();
@@ -181,6 +204,221 @@ void Application::mp1Run() {
     }
 }
 
+/**
+ * FUNCTION NAME: logStoreUsage
+ *
+ * DESCRIPTION: Log the memory taken by the hash tables of all nodes, per entry, and how
+ * 				much of their arenas holds no key or value
+ */
+void Application::logStoreUsage() {
+    TableUsage usage = TableUsage();
+    for (int i = 0; i < par->EN_GPSZ; i++) {
+        mp2[i]->addStoreUsage(usage);
+    }
+    if (usage.entries == 0) {
+        return;
+    }
+    log->LOG(&mp1[0]->getMemberNode()->addr,
+             "#STATSLOG# store: %zu entries, %.1f bytes/entry (%.1f table, %.1f arena), arena fragmentation %.2f",
+             usage.entries, (double) (usage.tableBytes + usage.arenaBytes) / usage.entries,
+             (double) usage.tableBytes / usage.entries, (double) usage.arenaBytes / usage.entries,
+             usage.arenaBytes ? (double) (usage.arenaBytes - usage.liveBytes) / usage.arenaBytes : 0.0);
+}
+
+/**
+ * FUNCTION NAME: logLoadSkew
+ *
+ * DESCRIPTION: Log the keys, requests and ring share of every node that is up, then the
+ * 				skew of each: its maximum over its mean
+ */
+void Application::logLoadSkew() {
+    double keys[2] = {0, 0};
+    double requests[2] = {0, 0};
+    double shares[2] = {0, 0};
+    int up = 0;
+    for (int i = 0; i < par->EN_GPSZ; i++) {
+        if (mp2[i]->getMemberNode()->bFailed) {
+            continue;
+        }
+        unsigned long nodeKeys = mp2[i]->getKeyCount();
+        long nodeRequests = mp2[i]->getRequestsServed();
+        double share = mp2[i]->ringShare();
+        log->LOG(&mp2[i]->getMemberNode()->addr, "#STATSLOG# load: %lu keys, %ld requests, %.3f of the ring",
+                 nodeKeys, nodeRequests, share);
+        keys[0] += nodeKeys;
+        keys[1] = std::max(keys[1], (double) nodeKeys);
+        requests[0] += nodeRequests;
+        requests[1] = std::max(requests[1], (double) nodeRequests);
+        shares[0] += share;
+        shares[1] = std::max(shares[1], share);
+        up++;
+    }
+    if (up == 0 || keys[0] == 0 || requests[0] == 0) {
+        return;
+    }
+    log->LOG(&mp1[0]->getMemberNode()->addr,
+             "#STATSLOG# load skew over %d nodes, %d vnodes each: keys %.2f, requests %.2f, ring share %.2f", up,
+             par->VNODES, keys[1] * up / keys[0], requests[1] * up / requests[0], shares[1] * up / shares[0]);
+}
+
+/**
+ * FUNCTION NAME: logPlacementCost
+ *
+ * DESCRIPTION: Log the time the nodes spent rebuilding their ring indexes, and with
+ * 				PLACEMENT_STATS the share of the key replicas and of the primaries an average
+ * 				membership change moved
+ */
+void Application::logPlacementCost() {
+    static const char *placements[] = {"ring", "maglev", "jump"};
+    PlacementCost cost = PlacementCost();
+    for (int i = 0; i < par->EN_GPSZ; i++) {
+        mp2[i]->addPlacementCost(cost);
+    }
+    if (cost.builds == 0) {
+        return;
+    }
+    if (cost.changes == 0) {
+        log->LOG(&mp1[0]->getMemberNode()->addr, "#STATSLOG# placement %s: %ld index builds, %.1f us each",
+                 placements[par->PLACEMENT], cost.builds, cost.buildMicros / cost.builds);
+        return;
+    }
+    log->LOG(&mp1[0]->getMemberNode()->addr,
+             "#STATSLOG# placement %s: %ld index builds, %.1f us each; %ld membership changes, moving %.3f of the replicas and %.3f of the primaries each",
+             placements[par->PLACEMENT], cost.builds, cost.buildMicros / cost.builds, cost.changes,
+             cost.movedReplicas / cost.changes, cost.movedOwners / cost.changes);
+}
+
+/**
+ * FUNCTION NAME: logTransferStats
+ *
+ * DESCRIPTION: Log the replica transfers of all nodes: records and the messages and bytes
+ * 				they took, and how long the range transfers took to be acknowledged
+ */
+void Application::logTransferStats() {
+    TransferStats stats = TransferStats();
+    for (int i = 0; i < par->EN_GPSZ; i++) {
+        mp2[i]->addTransferStats(stats);
+    }
+    if (stats.records == 0) {
+        return;
+    }
+    log->LOG(&mp1[0]->getMemberNode()->addr,
+             "#STATSLOG# transfers: %ld records in %ld messages (%ld resent, %ld refused by the network), %ld bytes; %ld of %ld streams acknowledged in %.1f rounds on average, %ld given up",
+             stats.records, stats.messages, stats.resent, stats.dropped, stats.bytes, stats.completed, stats.streams,
+             stats.completed ? (double) stats.rounds / stats.completed : 0.0, stats.abandoned);
+}
+
+/**
+ * FUNCTION NAME: logAntiEntropyStats
+ *
+ * DESCRIPTION: Log the Merkle tree exchanges of all nodes: how many found replicas apart,
+ * 				the traffic of the comparisons, and the keys repaired. The repairs travel as
+ * 				replica transfers, counted with those
+ */
+void Application::logAntiEntropyStats() {
+    AntiEntropyStats stats = AntiEntropyStats();
+    for (int i = 0; i < par->EN_GPSZ; i++) {
+        mp2[i]->addAntiEntropyStats(stats);
+    }
+    if (stats.exchanges == 0) {
+        return;
+    }
+    log->LOG(&mp1[0]->getMemberNode()->addr,
+             "#STATSLOG# anti-entropy: %ld exchanges, %ld diverged; %ld messages, %ld bytes, %ld leaves compared; %ld keys pushed, %ld pulled",
+             stats.exchanges, stats.diverged, stats.messages, stats.bytes, stats.leaves, stats.pushed, stats.pulled);
+}
+
+/**
+ * FUNCTION NAME: logFilterStats
+ *
+ * DESCRIPTION: Log the keys stabilization offered against the filters of new replicas:
+ * 				those left out, the record bytes they would have taken, and the traffic of
+ * 				the filters and digests that paid for it
+ */
+void Application::logFilterStats() {
+    FilterStats stats = FilterStats();
+    for (int i = 0; i < par->EN_GPSZ; i++) {
+        mp2[i]->addFilterStats(stats);
+    }
+    if (stats.offered == 0) {
+        return;
+    }
+    log->LOG(&mp1[0]->getMemberNode()->addr,
+             "#STATSLOG# stabilization filters: %ld keys offered, %ld confirmed by digest, %ld left out saving %ld record bytes; %ld filter and digest messages, %ld bytes; %ld offers timed out",
+             stats.offered, stats.confirmed, stats.skipped, stats.skippedBytes, stats.messages, stats.bytes, stats.expired);
+}
+
+/**
+ * FUNCTION NAME: logRebalanceStats
+ *
+ * DESCRIPTION: Log the rebalancing tasks of all nodes: how far they got, the rounds they
+ * 				took, and the time of their slices, which bounds the work of a round
+ */
+void Application::logRebalanceStats() {
+    RebalanceStats stats = RebalanceStats();
+    for (int i = 0; i < par->EN_GPSZ; i++) {
+        mp2[i]->addRebalanceStats(stats);
+    }
+    if (stats.tasks == 0) {
+        return;
+    }
+    log->LOG(&mp1[0]->getMemberNode()->addr,
+             "#STATSLOG# rebalancing: %ld tasks, %ld extended by a ring change, %ld finished in %.1f rounds on average; %ld slices went through %ld keys and sent %ld, %ld record bytes; slices took %.0f us on average, %.0f at most",
+             stats.tasks, stats.restarts, stats.finished, stats.finished ? (double) stats.rounds / stats.finished : 0.0,
+             stats.slices, stats.scanned, stats.queued, stats.bytes, stats.slices ? stats.sliceMicros / stats.slices : 0.0,
+             stats.maxSliceMicros);
+}
+
+/**
+ * FUNCTION NAME: logOpLatencies
+ *
+ * DESCRIPTION: Log the median and tail latency of the key-value operations that reached
+ * 				quorum, over all coordinators, and apart those started while some node
+ * 				was rebalancing
+ */
+void Application::logOpLatencies() {
+    vector<int> latencies;
+    vector<int> rebalancing;
+    for (int i = 0; i < par->EN_GPSZ; i++) {
+        const vector<pair<int, int>> &ops = mp2[i]->getOpLatencies();
+        std::for_each(ops.begin(), ops.end(), [this, &latencies, &rebalancing](const pair<int, int> &op) {
+            latencies.push_back(op.second);
+            if (rebalanceRounds.count(op.first)) {
+                rebalancing.push_back(op.second);
+            }
+        });
+    }
+    if (latencies.empty()) {
+        return;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    log->LOG(&mp1[0]->getMemberNode()->addr, "#STATSLOG# %zu key-value ops: p50 %d, p99 %d, max %d rounds",
+             latencies.size(), latencies[latencies.size() / 2], latencies[latencies.size() * 99 / 100],
+             latencies.back());
+    if (!rebalancing.empty()) {
+        std::sort(rebalancing.begin(), rebalancing.end());
+        log->LOG(&mp1[0]->getMemberNode()->addr, "#STATSLOG# %zu of them while rebalancing: p50 %d, p99 %d, max %d rounds",
+                 rebalancing.size(), rebalancing[rebalancing.size() / 2], rebalancing[rebalancing.size() * 99 / 100],
+                 rebalancing.back());
+    }
+}
+
+/**
+ * FUNCTION NAME: membershipConverged
+ *
+ * DESCRIPTION: Whether every node has been started and knows about every node
+ */
+bool Application::membershipConverged() {
+    for (int i = 0; i < par->EN_GPSZ; i++) {
+        Member *member = mp1[i]->getMemberNode();
+        if (!member->inited || member->bFailed || !member->inGroup ||
+            mp1[i]->knownMembers() != (size_t) par->EN_GPSZ) {
+            return false;
+        }
+    }
+    return true;
+}
+
 /**
  * FUNCTION NAME: mp2Run
  *
@@ -215,6 +453,9 @@ void Application::mp2Run() {
     for (i = par->EN_GPSZ - 1; i >= 0; i--) {
         if (par->getcurrtime() > (int) (par->STEP_RATE * i) && !mp2[i]->getMemberNode()->bFailed) {
             mp2[i]->checkMessages();
+            if (mp2[i]->rebalancing()) {
+                rebalanceRounds.insert(par->getcurrtime());
+            }
         }
     }
 
@@ -222,6 +463,7 @@ void Application::mp2Run() {
      * Insert a set of test key value pairs into the system
      */
     if (par->getcurrtime() == INSERT_TIME) {
+        preloadKeys();
         insertTestKVPairs();
     }
 
@@ -363,6 +605,52 @@ void Application::fail() {
 
 }
 
+/**
+ * FUNCTION NAME: leave
+ *
+ * DESCRIPTION: At LEAVE_TIME, the last LEAVE_COUNT nodes that are still up leave the group
+ * 				gracefully: they announce it and hand their keys off before stopping
+ */
+void Application::leave() {
+    if (par->LEAVE_COUNT <= 0 || par->getcurrtime() != par->LEAVE_TIME) {
+        return;
+    }
+    int left = 0;
+    for (int i = par->EN_GPSZ - 1; i >= 0 && left < par->LEAVE_COUNT; i--) {
+        Member *member = mp1[i]->getMemberNode();
+        if (member->inited && member->inGroup && !member->bFailed) {
+            mp1[i]->leaveGroup();
+            left++;
+        }
+    }
+    log->LOG(&mp1[0]->getMemberNode()->addr, "#STATSLOG# %d nodes left the group at time %d", left,
+             par->getcurrtime());
+}
+
+/**
+ * FUNCTION NAME: restart
+ *
+ * DESCRIPTION: At RESTART_TIME, every node that is down comes back with the store of its
+ * 				last snapshot and rejoins the group
+ */
+void Application::restart() {
+    if (par->RESTART_TIME <= 0 || par->getcurrtime() != par->RESTART_TIME) {
+        return;
+    }
+    int restarted = 0;
+    for (int i = 0; i < par->EN_GPSZ; i++) {
+        Member *member = mp1[i]->getMemberNode();
+        if (member->inited && member->bFailed) {
+            // The store first, it must see the membership events of the rejoin
+            mp2[i]->restart();
+            mp1[i]->rejoinGroup();
+            restarted++;
+        }
+    }
+    log->LOG(&mp1[0]->getMemberNode()->addr, "#STATSLOG# %d nodes restarted at time %d", restarted,
+             par->getcurrtime());
+}
+
 /**
  * FUNCTION NAME: getjoinaddr
  *
@@ -413,6 +701,32 @@ void Application::initTestKVPairs() {
     }
 }
 
+/**
+ * FUNCTION NAME: preloadKeys
+ *
+ * DESCRIPTION: Write PRELOAD_KEYS keys straight into the stores of their replicas, so that
+ * 				the test runs on a loaded cluster without sending a message per key
+ */
+void Application::preloadKeys() {
+    int number = findARandomNodeThatIsAlive();
+    for (int k = 0; k < par->PRELOAD_KEYS; k++) {
+        string key = "preload" + to_string(k);
+        string value = "value" + to_string(k % NUMBER_OF_INSERTS);
+        ReplicaSet replicas = mp2[number]->findNodes(key);
+        for (size_t r = 0; r < replicas.count; r++) {
+            Address *replica = mp2[number]->replicaAddress(replicas, r);
+            for (int i = 0; i < par->EN_GPSZ; i++) {
+                if (!memcmp(mp2[i]->getMemberNode()->addr.addr, replica->addr, sizeof(replica->addr))) {
+                    mp2[i]->preload(key, value);
+                }
+            }
+        }
+    }
+    if (par->PRELOAD_KEYS > 0) {
+        cout << endl << "Preloaded " << par->PRELOAD_KEYS << " keys" << endl;
+    }
+}
+
 /**
  * FUNCTION NAME: insertTestKVPairs
  *
@@ -488,7 +802,7 @@ void Application::readTest() {
     // This key is used for all read tests
     map<string, string>::iterator it = testKVPairs.begin();
     int number;
-    vector <Node> replicas;
+    ReplicaSet replicas;
     int replicaIdToFail = TERTIARY;
     int nodeToFail;
     bool failedOneNode = false;
@@ -517,21 +831,21 @@ void Application::readTest() {
         number = findARandomNodeThatIsAlive();
 
         // Step 2.b Find the replicas of this key
-        replicas.clear();
         replicas = mp2[number]->findNodes(it->first);
         // if less than quorum replicas are found then exit
-        if (replicas.size() < (RF - 1)) {
+        if (replicas.count < (RF - 1)) {
             cout << endl << "Could not find at least quorum replicas for this key. Exiting!!! size of replicas vector: "
-                 << replicas.size() << endl;
+                 << replicas.count << endl;
             log->LOG(&mp2[number]->getMemberNode()->addr,
                      "Could not find at least quorum replicas for this key. Exiting!!! size of replicas vector: %d",
-                     replicas.size());
+                     replicas.count);
             exit(1);
         }
 
         // Step 2.c Fail a replica
         for (int i = 0; i < par->EN_GPSZ; i++) {
-            if (mp2[i]->getMemberNode()->addr.getAddress() == replicas.at(replicaIdToFail).getAddress()->getAddress()) {
+            if (mp2[i]->getMemberNode()->addr.getAddress() ==
+                mp2[number]->replicaAddress(replicas, replicaIdToFail)->getAddress()) {
                 if (!mp2[i]->getMemberNode()->bFailed) {
                     nodeToFail = i;
                     failedOneNode = true;
@@ -585,18 +899,17 @@ void Application::readTest() {
             number = findARandomNodeThatIsAlive();
 
             // Get the keys replicas
-            replicas.clear();
             replicas = mp2[number]->findNodes(it->first);
 
             // Step 3.b. Fail two replicas
-            //cout<<"REPLICAS SIZE: "<<replicas.size();
-            if (replicas.size() > 2) {
+            //cout<<"REPLICAS SIZE: "<<replicas.count;
+            if (replicas.count > 2) {
                 replicaIdToFail = TERTIARY;
                 while (count != 2) {
                     int i = 0;
                     while (i != par->EN_GPSZ) {
                         if (mp2[i]->getMemberNode()->addr.getAddress() ==
-                            replicas.at(replicaIdToFail).getAddress()->getAddress()) {
+                            mp2[number]->replicaAddress(replicas, replicaIdToFail)->getAddress()) {
                             if (!mp2[i]->getMemberNode()->bFailed) {
                                 nodesToFail.emplace_back(i);
                                 replicaIdToFail--;
@@ -615,7 +928,7 @@ void Application::readTest() {
             } else {
                 // If the code reaches here. Test your stabilization protocol
                 cout << endl << "Not enough replicas to fail two nodes. Number of replicas of this key: "
-                     << replicas.size() << ". Exiting test case !! " << endl;
+                     << replicas.count << ". Exiting test case !! " << endl;
                 exit(1);
             }
             if (count == 2) {
@@ -670,13 +983,12 @@ void Application::readTest() {
         number = findARandomNodeThatIsAlive();
 
         // Step 4.b Find a non - replica for this key
-        replicas.clear();
         replicas = mp2[number]->findNodes(it->first);
         for (int i = 0; i < par->EN_GPSZ; i++) {
             if (!mp2[i]->getMemberNode()->bFailed) {
-                if (mp2[i]->getMemberNode()->addr.getAddress() != replicas.at(PRIMARY).getAddress()->getAddress() &&
-                    mp2[i]->getMemberNode()->addr.getAddress() != replicas.at(SECONDARY).getAddress()->getAddress() &&
-                    mp2[i]->getMemberNode()->addr.getAddress() != replicas.at(TERTIARY).getAddress()->getAddress()) {
+                if (mp2[i]->getMemberNode()->addr.getAddress() != mp2[number]->replicaAddress(replicas, PRIMARY)->getAddress() &&
+                    mp2[i]->getMemberNode()->addr.getAddress() != mp2[number]->replicaAddress(replicas, SECONDARY)->getAddress() &&
+                    mp2[i]->getMemberNode()->addr.getAddress() != mp2[number]->replicaAddress(replicas, TERTIARY)->getAddress()) {
                     // Step 4.c Fail a non-replica node
                     log->LOG(&mp2[i]->getMemberNode()->addr, "Node failed at time=%d", par->getcurrtime());
                     mp2[i]->getMemberNode()->bFailed = true;
@@ -739,7 +1051,7 @@ void Application::updateTest() {
     it++;
     string newValue = "newValue";
     int number;
-    vector <Node> replicas;
+    ReplicaSet replicas;
     int replicaIdToFail = TERTIARY;
     int nodeToFail;
     bool failedOneNode = false;
@@ -768,21 +1080,21 @@ void Application::updateTest() {
         number = findARandomNodeThatIsAlive();
 
         // Step 2.b Find the replicas of this key
-        replicas.clear();
         replicas = mp2[number]->findNodes(it->first);
         // if quorum replicas are not found then exit
-        if (replicas.size() < RF - 1) {
+        if (replicas.count < RF - 1) {
             log->LOG(&mp2[number]->getMemberNode()->addr,
                      "Could not find at least quorum replicas for this key. Exiting!!! size of replicas vector: %d",
-                     replicas.size());
+                     replicas.count);
             cout << endl << "Could not find at least quorum replicas for this key. Exiting!!! size of replicas vector: "
-                 << replicas.size() << endl;
+                 << replicas.count << endl;
             exit(1);
         }
 
         // Step 2.c Fail a replica
         for (int i = 0; i < par->EN_GPSZ; i++) {
-            if (mp2[i]->getMemberNode()->addr.getAddress() == replicas.at(replicaIdToFail).getAddress()->getAddress()) {
+            if (mp2[i]->getMemberNode()->addr.getAddress() ==
+                mp2[number]->replicaAddress(replicas, replicaIdToFail)->getAddress()) {
                 if (!mp2[i]->getMemberNode()->bFailed) {
                     nodeToFail = i;
                     failedOneNode = true;
@@ -836,17 +1148,16 @@ void Application::updateTest() {
             number = findARandomNodeThatIsAlive();
 
             // Get the keys replicas
-            replicas.clear();
             replicas = mp2[number]->findNodes(it->first);
 
             // Step 3.b. Fail two replicas
-            if (replicas.size() > 2) {
+            if (replicas.count > 2) {
                 replicaIdToFail = TERTIARY;
                 while (count != 2) {
                     int i = 0;
                     while (i != par->EN_GPSZ) {
                         if (mp2[i]->getMemberNode()->addr.getAddress() ==
-                            replicas.at(replicaIdToFail).getAddress()->getAddress()) {
+                            mp2[number]->replicaAddress(replicas, replicaIdToFail)->getAddress()) {
                             if (!mp2[i]->getMemberNode()->bFailed) {
                                 nodesToFail.emplace_back(i);
                                 replicaIdToFail--;
@@ -917,13 +1228,12 @@ void Application::updateTest() {
         number = findARandomNodeThatIsAlive();
 
         // Step 4.b Find a non - replica for this key
-        replicas.clear();
         replicas = mp2[number]->findNodes(it->first);
         for (int i = 0; i < par->EN_GPSZ; i++) {
             if (!mp2[i]->getMemberNode()->bFailed) {
-                if (mp2[i]->getMemberNode()->addr.getAddress() != replicas.at(PRIMARY).getAddress()->getAddress() &&
-                    mp2[i]->getMemberNode()->addr.getAddress() != replicas.at(SECONDARY).getAddress()->getAddress() &&
-                    mp2[i]->getMemberNode()->addr.getAddress() != replicas.at(TERTIARY).getAddress()->getAddress()) {
+                if (mp2[i]->getMemberNode()->addr.getAddress() != mp2[number]->replicaAddress(replicas, PRIMARY)->getAddress() &&
+                    mp2[i]->getMemberNode()->addr.getAddress() != mp2[number]->replicaAddress(replicas, SECONDARY)->getAddress() &&
+                    mp2[i]->getMemberNode()->addr.getAddress() != mp2[number]->replicaAddress(replicas, TERTIARY)->getAddress()) {
                     // Step 4.c Fail a non-replica node
                     log->LOG(&mp2[i]->getMemberNode()->addr, "Node failed at time=%d", par->getcurrtime());
                     mp2[i]->getMemberNode()->bFailed = true;
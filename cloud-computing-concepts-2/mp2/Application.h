@@ -58,6 +58,8 @@ private:
     MP2Node **mp2;
     Params *par;
     map <string, string> testKVPairs;
+    // Rounds in which some node ran a slice of rebalancing
+    set <int> rebalanceRounds;
 public:
     Application(char *);
 
@@ -73,8 +75,32 @@ public:
 
     void mp2Run();
 
+    bool membershipConverged();
+
+    void logOpLatencies();
+
+    void logStoreUsage();
+
+    void logLoadSkew();
+
+    void logPlacementCost();
+
+    void logTransferStats();
+
+    void logAntiEntropyStats();
+
+    void logFilterStats();
+
+    void logRebalanceStats();
+
     void fail();
 
+    void leave();
+
+    void restart();
+
+    void preloadKeys();
+
     void insertTestKVPairs();
 
     int findARandomNodeThatIsAlive();
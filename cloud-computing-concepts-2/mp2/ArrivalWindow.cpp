@@ -0,0 +1,80 @@
+/**********************************
+ * FILE NAME: ArrivalWindow.cpp
+ *
+ * DESCRIPTION: ArrivalWindow class definition
+ **********************************/
+
+#include "ArrivalWindow.h"
+
+/**
+ * Constructor
+ */
+ArrivalWindow::ArrivalWindow() : head(0), count(0), sum(0), sumSquares(0) {}
+
+/**
+ * FUNCTION NAME: record
+ *
+ * DESCRIPTION: Add the time between two heartbeats, evicting the oldest one once the
+ * 				window is full
+ */
+void ArrivalWindow::record(long interval) {
+    if (interval > USHRT_MAX) {
+        interval = USHRT_MAX;
+    }
+    if (count == ARRIVAL_WINDOW) {
+        sum -= intervals[head];
+        sumSquares -= (long) intervals[head] * intervals[head];
+    } else {
+        count++;
+    }
+    intervals[head] = (unsigned short) interval;
+    sum += interval;
+    sumSquares += interval * interval;
+    head = (head + 1) % ARRIVAL_WINDOW;
+}
+
+/**
+ * FUNCTION NAME: empty
+ *
+ * DESCRIPTION: Whether no interval has been recorded yet
+ */
+bool ArrivalWindow::empty() const {
+    return count == 0;
+}
+
+/**
+ * FUNCTION NAME: phi
+ *
+ * DESCRIPTION: Suspicion level after elapsed ticks without a heartbeat. Uses the logistic
+ * 				approximation of the normal CDF, which stays finite far in the tail.
+ */
+double ArrivalWindow::phi(long elapsed) const {
+    if (count == 0) {
+        return 0;
+    }
+    double mean = (double) sum / count;
+    double variance = (double) sumSquares / count - mean * mean;
+    double stddev = std::max(sqrt(std::max(variance, 0.0)), PHI_MIN_STDDEV);
+
+    double y = (elapsed - mean) / stddev;
+    double e = exp(-y * (1.5976 + 0.070566 * y * y));
+    if (elapsed > mean) {
+        return -log10(e / (1.0 + e));
+    }
+    return -log10(1.0 - 1.0 / (1.0 + e));
+}
+
+/**
+ * FUNCTION NAME: crossing
+ *
+ * DESCRIPTION: Returns the first tick after the last heartbeat at which phi reaches
+ * 				threshold. phi grows with the elapsed time, so this is the deadline the
+ * 				failure timer of the member is armed for.
+ */
+long ArrivalWindow::crossing(double threshold) const {
+    long elapsed = count ? std::max(sum / count, 1L) : 1;
+    while (phi(elapsed) < threshold && elapsed < USHRT_MAX) {
+        elapsed++;
+    }
+    return elapsed;
+}
@@ -0,0 +1,52 @@
+/**********************************
+ * FILE NAME: ArrivalWindow.h
+ *
+ * DESCRIPTION: Header file of ArrivalWindow class
+ **********************************/
+
+#ifndef ARRIVALWINDOW_H_
+#define ARRIVALWINDOW_H_
+
+#include "stdincludes.h"
+
+/**
+ * Macros
+ */
+// Number of heartbeat inter-arrival times kept per member
+#define ARRIVAL_WINDOW 16
+// Lower bound of the standard deviation, in ticks, so that a perfectly regular
+// member is not declared failed one tick after it misses a beat
+#define PHI_MIN_STDDEV 1.0
+
+/**
+ * CLASS NAME: ArrivalWindow
+ *
+ * DESCRIPTION: Sliding window of the heartbeat inter-arrival times of one member for the
+ * 				phi-accrual failure detector. The intervals live in a fixed ring buffer and
+ * 				the running sum and sum of squares are kept alongside, so the suspicion
+ * 				level phi is computed in constant time. Arrival times are modelled as
+ * 				normally distributed; phi is -log10 of the probability that the next
+ * 				heartbeat is still to come after elapsed ticks.
+ */
+class ArrivalWindow {
+private:
+    unsigned short intervals[ARRIVAL_WINDOW];
+    // Position the next interval is written to
+    unsigned short head;
+    unsigned short count;
+    long sum;
+    long sumSquares;
+
+public:
+    ArrivalWindow();
+
+    void record(long interval);
+
+    bool empty() const;
+
+    double phi(long elapsed) const;
+
+    long crossing(double threshold) const;
+};
+
+#endif /* ARRIVALWINDOW_H_ */
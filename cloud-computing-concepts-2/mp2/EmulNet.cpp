@@ -16,6 +16,9 @@ EmulNet::EmulNet(Params *p) {
     emulnet.setNextId(1);
     emulnet.settCurrBuffSize(0);
     enInited = 0;
+    sentBytes = 0;
+    crossZoneMsgs = 0;
+    crossZoneBytes = 0;
     for (i = 0; i < MAX_NODES; i++) {
         for (j = 0; j < MAX_TIME; j++) {
             sent_msgs[i][j] = 0;
@@ -100,11 +103,21 @@ int EmulNet::ENsend(Address *myaddr, Address *toaddr, char *data, int size) {
     memcpy(&(em->to.addr), &(toaddr->addr), sizeof(em->from.addr));
     memcpy(em + 1, data, size);
 
-    emulnet.buff[emulnet.currbuffsize++] = em;
-
     int src = *(int *) (myaddr->addr);
+    int dst = *(int *) (toaddr->addr);
     int time = par->getcurrtime();
 
+    // Latency model: a message crossing zones is held back ZONE_DELAY rounds
+    em->deliverAt = time;
+    sentBytes += size;
+    if (par->zoneOf(src) != par->zoneOf(dst)) {
+        em->deliverAt += par->ZONE_DELAY;
+        crossZoneMsgs++;
+        crossZoneBytes += size;
+    }
+
+    emulnet.buff[emulnet.currbuffsize++] = em;
+
     assert(src <= MAX_NODES);
     assert(time < MAX_TIME);
 
@@ -152,7 +165,8 @@ int EmulNet::ENrecv(Address *myaddr, int (*enq)(void *, char *, int), struct tim
     for (i = emulnet.currbuffsize - 1; i >= 0; i--) {
         emsg = emulnet.buff[i];
 
-        if (0 == strcmp(emsg->to.addr, myaddr->addr)) {
+        if (0 == memcmp(emsg->to.addr, myaddr->addr, sizeof(myaddr->addr)) &&
+            emsg->deliverAt <= par->getcurrtime()) {
             sz = emsg->size;
             tmp = (char *) malloc(sz * sizeof(char));
             memcpy(tmp, (char *) (emsg + 1), sz);
@@ -177,6 +191,31 @@ int EmulNet::ENrecv(Address *myaddr, int (*enq)(void *, char *, int), struct tim
     return 0;
 }
 
+/**
+ * FUNCTION NAME: ENsentTotal
+ *
+ * DESCRIPTION: Number of messages sent by all nodes so far
+ */
+long EmulNet::ENsentTotal() {
+    long total = 0;
+    for (int i = 1; i <= par->EN_GPSZ; i++) {
+        for (int j = 0; j <= par->getcurrtime() && j < MAX_TIME; j++) {
+            total += sent_msgs[i][j];
+        }
+    }
+    return total;
+}
+
+/**
+ * FUNCTION NAME: ENlogTraffic
+ *
+ * DESCRIPTION: Log the messages and bytes sent so far, and the part that crossed zones
+ */
+void EmulNet::ENlogTraffic(Log *log, Address *addr, const char *name) {
+    log->LOG(addr, "#STATSLOG# %s: %ld messages, %ld bytes; cross-zone %ld messages, %ld bytes", name,
+             ENsentTotal(), sentBytes, crossZoneMsgs, crossZoneBytes);
+}
+
 /**
  * FUNCTION NAME: ENcleanup
  *
@@ -14,6 +14,7 @@
 #include "stdincludes.h"
 #include "Params.h"
 #include "Member.h"
+#include "Log.h"
 
 using namespace std;
 
@@ -27,6 +28,8 @@ typedef struct en_msg {
     Address from;
     // Destination node
     Address to;
+    // Time from which the message can be received
+    int deliverAt;
 } en_msg;
 
 /**
@@ -92,6 +95,10 @@ private:
     int recv_msgs[MAX_NODES + 1][MAX_TIME];
     int enInited;
     EM emulnet;
+    // Messages and bytes sent, and how many of them crossed zones
+    long sentBytes;
+    long crossZoneMsgs;
+    long crossZoneBytes;
 public:
     EmulNet(Params *p);
 
@@ -110,6 +117,10 @@ public:
     int ENrecv(Address *myaddr, int (*enq)(void *, char *, int), struct timeval *t, int times, void *queue);
 
     int ENcleanup();
+
+    long ENsentTotal();
+
+    void ENlogTraffic(Log *log, Address *addr, const char *name);
 };
 
 #endif /* _EMULNET_H_ */
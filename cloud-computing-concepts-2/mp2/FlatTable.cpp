@@ -0,0 +1,353 @@
+/**********************************
+ * FILE NAME: FlatTable.cpp
+ *
+ * DESCRIPTION: FlatTable class definition
+ **********************************/
+
+#include "FlatTable.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * Constructor
+ */
+FlatTable::FlatTable() {
+    slots = NULL;
+    ctrl = NULL;
+    capacity = 0;
+    entries = 0;
+    tombstones = 0;
+}
+
+/**
+ * Destructor
+ */
+FlatTable::~FlatTable() {
+    delete[] slots;
+    delete[] ctrl;
+}
+
+/**
+ * FUNCTION NAME: hashOf
+ *
+ * DESCRIPTION: Returns the hash of key, the same as std::hash <string> gives
+ */
+size_t FlatTable::hashOf(string_view key) {
+    return std::hash<string_view>()(key);
+}
+
+/**
+ * FUNCTION NAME: matchByte
+ *
+ * DESCRIPTION: Returns a bit mask of the control bytes of group equal to byte
+ */
+uint32_t FlatTable::matchByte(const int8_t *group, int8_t byte) {
+#ifdef __SSE2__
+    __m128i bytes = _mm_loadu_si128((const __m128i *) group);
+    return (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(byte)));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < FLAT_GROUP; i++) {
+        mask |= (uint32_t) (group[i] == byte) << i;
+    }
+    return mask;
+#endif
+}
+
+/**
+ * FUNCTION NAME: matchFree
+ *
+ * DESCRIPTION: Returns a bit mask of the empty or deleted slots of group
+ */
+uint32_t FlatTable::matchFree(const int8_t *group) {
+#ifdef __SSE2__
+    // Free control bytes are the negative ones, so their sign bits are the mask
+    return (uint32_t) _mm_movemask_epi8(_mm_loadu_si128((const __m128i *) group));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < FLAT_GROUP; i++) {
+        mask |= (uint32_t) (group[i] < 0) << i;
+    }
+    return mask;
+#endif
+}
+
+/**
+ * FUNCTION NAME: probe
+ *
+ * DESCRIPTION: Returns the slot holding key, capacity if there is none. The probe stops
+ * 				at the first group with an empty slot, as an insert would have used it
+ */
+size_t FlatTable::probe(string_view key, size_t hash) const {
+    if (capacity == 0) {
+        return capacity;
+    }
+    size_t mask = capacity / FLAT_GROUP - 1;
+    size_t group = (hash >> 7) & mask;
+    int8_t h2 = (int8_t) (hash & 0x7f);
+    for (size_t step = 1; ; step++) {
+        const int8_t *at = ctrl + group * FLAT_GROUP;
+        for (uint32_t match = matchByte(at, h2); match; match &= match - 1) {
+            size_t index = group * FLAT_GROUP + __builtin_ctz(match);
+            const FlatSlot &slot = slots[index];
+            if (slot.hash == hash && string_view(slot.key, slot.keySize) == key) {
+                return index;
+            }
+        }
+        if (matchByte(at, FLAT_EMPTY)) {
+            return capacity;
+        }
+        // Triangular steps visit every group of a power of two table
+        group = (group + step) & mask;
+    }
+}
+
+/**
+ * FUNCTION NAME: findFree
+ *
+ * DESCRIPTION: Returns the first empty or deleted slot on the probe sequence of hash
+ */
+size_t FlatTable::findFree(size_t hash) const {
+    size_t mask = capacity / FLAT_GROUP - 1;
+    size_t group = (hash >> 7) & mask;
+    for (size_t step = 1; ; step++) {
+        uint32_t match = matchFree(ctrl + group * FLAT_GROUP);
+        if (match) {
+            return group * FLAT_GROUP + __builtin_ctz(match);
+        }
+        group = (group + step) & mask;
+    }
+}
+
+/**
+ * FUNCTION NAME: rehash
+ *
+ * DESCRIPTION: Move every entry to a table of newCapacity slots, dropping the tombstones.
+ * 				Stored hashes are reused, keys are not hashed again, and the bytes of keys
+ * 				and values stay where they are in the arena
+ */
+void FlatTable::rehash(size_t newCapacity) {
+    FlatSlot *oldSlots = slots;
+    int8_t *oldCtrl = ctrl;
+    size_t oldCapacity = capacity;
+
+    slots = new FlatSlot[newCapacity];
+    ctrl = new int8_t[newCapacity];
+    memset(ctrl, FLAT_EMPTY, newCapacity);
+    capacity = newCapacity;
+    tombstones = 0;
+
+    for (size_t i = 0; i < oldCapacity; i++) {
+        if (oldCtrl[i] < 0) {
+            continue;
+        }
+        size_t index = findFree(oldSlots[i].hash);
+        ctrl[index] = oldCtrl[i];
+        slots[index] = oldSlots[i];
+    }
+    delete[] oldSlots;
+    delete[] oldCtrl;
+}
+
+/**
+ * FUNCTION NAME: begin
+ *
+ * DESCRIPTION: Returns an iterator to the first entry
+ */
+FlatTable::iterator FlatTable::begin() {
+    return iterator(this, 0);
+}
+
+/**
+ * FUNCTION NAME: end
+ *
+ * DESCRIPTION: Returns the iterator past the last entry
+ */
+FlatTable::iterator FlatTable::end() {
+    return iterator(this, capacity);
+}
+
+/**
+ * FUNCTION NAME: find
+ *
+ * DESCRIPTION: Returns the entry of key, end() if there is none
+ */
+FlatTable::iterator FlatTable::find(string_view key) {
+    return iterator(this, probe(key, hashOf(key)));
+}
+
+/**
+ * FUNCTION NAME: emplace
+ *
+ * DESCRIPTION: Insert key with value unless key is already in the table. The table grows
+ * 				twofold before it is 7/8 full; when it is mostly tombstones it is only
+ * 				rehashed in place
+ *
+ * RETURNS:
+ * the entry of key, and whether it was inserted
+ */
+pair<FlatTable::iterator, bool> FlatTable::emplace(string_view key, string_view value) {
+    size_t hash = hashOf(key);
+    size_t index = probe(key, hash);
+    if (index < capacity) {
+        return make_pair(iterator(this, index), false);
+    }
+    if ((entries + tombstones + 1) * 8 > capacity * 7) {
+        // Grow unless tombstones make up half of the load
+        if (capacity == 0) {
+            rehash(FLAT_GROUP);
+        } else if ((entries + 1) * 16 > capacity * 7) {
+            rehash(capacity * 2);
+        } else {
+            rehash(capacity);
+        }
+    }
+    index = findFree(hash);
+    if (ctrl[index] == FLAT_DELETED) {
+        tombstones--;
+    }
+    ctrl[index] = (int8_t) (hash & 0x7f);
+    FlatSlot &slot = slots[index];
+    slot.hash = hash;
+    slot.key = arena.store(key);
+    slot.keySize = (uint32_t) key.size();
+    slot.value = arena.store(value);
+    slot.valueSize = (uint32_t) value.size();
+    entries++;
+    compactIfSparse();
+    return make_pair(iterator(this, index), true);
+}
+
+/**
+ * FUNCTION NAME: assign
+ *
+ * DESCRIPTION: Set the value of the entry at it. The new value overwrites the old one
+ * 				when both fall in the same size class
+ */
+void FlatTable::assign(iterator it, string_view value) {
+    FlatSlot &slot = slots[it.index];
+    slot.value = arena.replace(slot.value, slot.valueSize, value);
+    slot.valueSize = (uint32_t) value.size();
+    compactIfSparse();
+}
+
+/**
+ * FUNCTION NAME: erase
+ *
+ * DESCRIPTION: Remove the entry at it. Its slot is marked empty if its group has an
+ * 				empty slot already, as probes stop at that group anyway; otherwise it
+ * 				becomes a tombstone so that probes go on past it
+ *
+ * RETURNS:
+ * an iterator to the entry after it
+ */
+FlatTable::iterator FlatTable::erase(iterator it) {
+    size_t index = it.index;
+    arena.release(slots[index].key, slots[index].keySize);
+    arena.release(slots[index].value, slots[index].valueSize);
+    if (matchByte(ctrl + index / FLAT_GROUP * FLAT_GROUP, FLAT_EMPTY)) {
+        ctrl[index] = FLAT_EMPTY;
+    } else {
+        ctrl[index] = FLAT_DELETED;
+        tombstones++;
+    }
+    entries--;
+    return ++it;
+}
+
+/**
+ * FUNCTION NAME: count
+ *
+ * DESCRIPTION: Returns 1 if key is in the table, 0 otherwise
+ */
+size_t FlatTable::count(string_view key) const {
+    return probe(key, hashOf(key)) < capacity;
+}
+
+/**
+ * FUNCTION NAME: size
+ *
+ * DESCRIPTION: Returns the number of entries
+ */
+size_t FlatTable::size() const {
+    return entries;
+}
+
+/**
+ * FUNCTION NAME: empty
+ *
+ * DESCRIPTION: Returns whether the table has no entry
+ */
+bool FlatTable::empty() const {
+    return entries == 0;
+}
+
+/**
+ * FUNCTION NAME: bucketCount
+ *
+ * DESCRIPTION: Returns the number of slots
+ */
+size_t FlatTable::bucketCount() const {
+    return capacity;
+}
+
+/**
+ * FUNCTION NAME: addUsage
+ *
+ * DESCRIPTION: Add the memory taken by this table to usage
+ */
+void FlatTable::addUsage(TableUsage &usage) const {
+    usage.entries += entries;
+    usage.tableBytes += capacity * (sizeof(FlatSlot) + sizeof(int8_t));
+    usage.arenaBytes += arena.reservedBytes();
+    usage.allocatedBytes += arena.allocatedBytes();
+    usage.liveBytes += arena.liveBytes();
+}
+
+/**
+ * FUNCTION NAME: compact
+ *
+ * DESCRIPTION: Copy every key and value into a fresh arena sized for them, dropping the
+ * 				free blocks of the old one
+ */
+void FlatTable::compact() {
+    StringArena fresh(arena.allocatedBytes());
+    for (size_t i = 0; i < capacity; i++) {
+        if (ctrl[i] < 0) {
+            continue;
+        }
+        FlatSlot &slot = slots[i];
+        slot.key = fresh.store(string_view(slot.key, slot.keySize));
+        slot.value = fresh.store(string_view(slot.value, slot.valueSize));
+    }
+    arena.swap(fresh);
+}
+
+/**
+ * FUNCTION NAME: compactIfSparse
+ *
+ * DESCRIPTION: Compact the arena once two thirds of it are free. A fresh arena is at
+ * 				least half used, so compactions do not follow each other
+ */
+void FlatTable::compactIfSparse() {
+    if (arena.reservedBytes() >= FLAT_COMPACT_MIN && arena.allocatedBytes() * 3 < arena.reservedBytes()) {
+        compact();
+    }
+}
+
+/**
+ * FUNCTION NAME: clear
+ *
+ * DESCRIPTION: Remove every entry, keeping the slots
+ */
+void FlatTable::clear() {
+    StringArena fresh;
+    arena.swap(fresh);
+    if (capacity) {
+        memset(ctrl, FLAT_EMPTY, capacity);
+    }
+    entries = 0;
+    tombstones = 0;
+}
@@ -0,0 +1,184 @@
+/**********************************
+ * FILE NAME: FlatTable.h
+ *
+ * DESCRIPTION: Header file of FlatTable class
+ **********************************/
+
+#ifndef FLATTABLE_H_
+#define FLATTABLE_H_
+
+#include "stdincludes.h"
+#include "StringArena.h"
+
+/**
+ * Macros
+ */
+// Control byte of a slot that was never used, and of one whose entry was erased. A full
+// slot holds the low 7 bits of the hash of its key, so control bytes < 0 are free slots
+#define FLAT_EMPTY ((int8_t) -128)
+#define FLAT_DELETED ((int8_t) -2)
+// Slots probed at once, the 16 control bytes of an SSE2 register
+#define FLAT_GROUP 16
+// The arena is compacted when a third or less of it is in use, past this size
+#define FLAT_COMPACT_MIN ARENA_MAX_CHUNK
+
+/**
+ * STRUCT NAME: FlatSlot
+ *
+ * DESCRIPTION: An entry of the table with the full hash of its key, so that probes and
+ * 				rehashes rarely compare or rehash keys. The bytes of the key and of the
+ * 				value live in the arena of the table
+ */
+typedef struct FlatSlot {
+    size_t hash;
+    char *key;
+    char *value;
+    uint32_t keySize;
+    uint32_t valueSize;
+} FlatSlot;
+
+/**
+ * STRUCT NAME: TableUsage
+ *
+ * DESCRIPTION: Memory taken by one or more tables
+ */
+typedef struct TableUsage {
+    size_t entries;
+    // slots and control bytes
+    size_t tableBytes;
+    // arena chunks, the blocks of them in use, and the key and value bytes in those
+    size_t arenaBytes;
+    size_t allocatedBytes;
+    size_t liveBytes;
+} TableUsage;
+
+/**
+ * CLASS NAME: FlatTable
+ *
+ * DESCRIPTION: Open-addressing hash table of strings, after Swiss tables: one control byte
+ * 				per slot, kept apart from the slots, and groups of FLAT_GROUP control bytes
+ * 				matched against 7 bits of the hash at once, with SSE2 where available. The
+ * 				upper bits of the hash pick the first group, the next ones are probed
+ * 				triangularly. Slots are one flat array; iteration order is unspecified.
+ * 				Keys are stored once, in the arena of the table, and values are written
+ * 				in place while they fit their size class. Entries are views into the
+ * 				arena, valid until the next write to the table.
+ */
+class FlatTable {
+public:
+    class iterator {
+    private:
+        FlatTable *table;
+        size_t index;
+
+        void skipFree() {
+            while (index < table->capacity && table->ctrl[index] < 0) {
+                index++;
+            }
+        }
+
+        friend class FlatTable;
+
+    public:
+        // Entries are made up on the fly, so iterators are input iterators
+        typedef std::input_iterator_tag iterator_category;
+        typedef pair<string_view, string_view> value_type;
+        typedef ptrdiff_t difference_type;
+        typedef value_type reference;
+
+        struct pointer {
+            value_type entry;
+
+            const value_type *operator->() const {
+                return &entry;
+            }
+        };
+
+        iterator(FlatTable *table, size_t index) : table(table), index(index) {
+            skipFree();
+        }
+
+        reference operator*() const {
+            const FlatSlot &slot = table->slots[index];
+            return value_type(string_view(slot.key, slot.keySize), string_view(slot.value, slot.valueSize));
+        }
+
+        pointer operator->() const {
+            return pointer{**this};
+        }
+
+        iterator &operator++() {
+            index++;
+            skipFree();
+            return *this;
+        }
+
+        bool operator==(const iterator &other) const {
+            return index == other.index;
+        }
+
+        bool operator!=(const iterator &other) const {
+            return index != other.index;
+        }
+    };
+
+private:
+    FlatSlot *slots;
+    int8_t *ctrl;
+    // Number of slots, a power of two and a multiple of FLAT_GROUP, or 0 before the first insert
+    size_t capacity;
+    size_t entries;
+    size_t tombstones;
+    StringArena arena;
+
+    static size_t hashOf(string_view key);
+
+    static uint32_t matchByte(const int8_t *group, int8_t byte);
+
+    static uint32_t matchFree(const int8_t *group);
+
+    size_t probe(string_view key, size_t hash) const;
+
+    size_t findFree(size_t hash) const;
+
+    void rehash(size_t newCapacity);
+
+    void compactIfSparse();
+
+public:
+    FlatTable();
+
+    FlatTable(const FlatTable &) = delete;
+
+    FlatTable &operator=(const FlatTable &) = delete;
+
+    iterator begin();
+
+    iterator end();
+
+    iterator find(string_view key);
+
+    pair<iterator, bool> emplace(string_view key, string_view value);
+
+    void assign(iterator it, string_view value);
+
+    iterator erase(iterator it);
+
+    size_t count(string_view key) const;
+
+    size_t size() const;
+
+    bool empty() const;
+
+    size_t bucketCount() const;
+
+    void addUsage(TableUsage &usage) const;
+
+    void compact();
+
+    void clear();
+
+    virtual ~FlatTable();
+};
+
+#endif /* FLATTABLE_H_ */
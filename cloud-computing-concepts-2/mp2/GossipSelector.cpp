@@ -0,0 +1,87 @@
+/**********************************
+ * FILE NAME: GossipSelector.cpp
+ *
+ * DESCRIPTION: GossipSelector class definition
+ **********************************/
+
+#include "GossipSelector.h"
+
+/**
+ * Constructor
+ */
+GossipSelector::GossipSelector() : cursor(0), state(0x9E3779B97F4A7C15ULL) {}
+
+/**
+ * Destructor
+ */
+GossipSelector::~GossipSelector() {}
+
+/**
+ * FUNCTION NAME: seed
+ *
+ * DESCRIPTION: Seed the PRNG. The seed is run through a splitmix64 step so that
+ * 				neighbouring seeds give unrelated streams.
+ */
+void GossipSelector::seed(unsigned long long seed) {
+    unsigned long long z = seed + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z = z ^ (z >> 31);
+    // xorshift must never be seeded with zero
+    state = z ? z : 0x9E3779B97F4A7C15ULL;
+}
+
+/**
+ * FUNCTION NAME: nextRandom
+ *
+ * DESCRIPTION: Returns the next 64 bit value of the xorshift64* generator
+ */
+unsigned long long GossipSelector::nextRandom() {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * FUNCTION NAME: reshuffle
+ *
+ * DESCRIPTION: Start a new pass over keys in a fresh random order
+ */
+void GossipSelector::reshuffle(vector<long> keys) {
+    order.swap(keys);
+    for (size_t i = order.size(); i > 1; i--) {
+        size_t j = nextRandom() % i;
+        std::swap(order[i - 1], order[j]);
+    }
+    cursor = 0;
+}
+
+/**
+ * FUNCTION NAME: add
+ *
+ * DESCRIPTION: Insert a member that joined mid-pass at a random position among the
+ * 				members not yet visited, so it is still contacted during this pass
+ */
+void GossipSelector::add(long key) {
+    order.push_back(key);
+    size_t remaining = order.size() - cursor;
+    size_t j = cursor + nextRandom() % remaining;
+    std::swap(order[order.size() - 1], order[j]);
+}
+
+/**
+ * FUNCTION NAME: next
+ *
+ * DESCRIPTION: Returns the next key of the pass
+ *
+ * RETURNS:
+ * false once the pass is exhausted
+ */
+bool GossipSelector::next(long &key) {
+    if (cursor >= order.size()) {
+        return false;
+    }
+    key = order[cursor++];
+    return true;
+}
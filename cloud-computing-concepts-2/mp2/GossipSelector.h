@@ -0,0 +1,45 @@
+/**********************************
+ * FILE NAME: GossipSelector.h
+ *
+ * DESCRIPTION: Header file of GossipSelector class
+ **********************************/
+
+#ifndef GOSSIPSELECTOR_H_
+#define GOSSIPSELECTOR_H_
+
+#include "stdincludes.h"
+
+/**
+ * CLASS NAME: GossipSelector
+ *
+ * DESCRIPTION: Picks gossip targets by walking a shuffled permutation of the members
+ * 				round-robin and reshuffling once per pass. Every member that stays in the
+ * 				group is contacted once per pass, i.e. within ceil(N / fanout) rounds.
+ * 				Each node owns one selector and with it one xorshift PRNG.
+ */
+class GossipSelector {
+private:
+    // Member keys in the order of the current pass
+    vector<long> order;
+    // Next position of the pass
+    size_t cursor;
+    // xorshift64* state
+    unsigned long long state;
+
+public:
+    GossipSelector();
+
+    void seed(unsigned long long seed);
+
+    unsigned long long nextRandom();
+
+    void reshuffle(vector<long> keys);
+
+    void add(long key);
+
+    bool next(long &key);
+
+    virtual ~GossipSelector();
+};
+
+#endif /* GOSSIPSELECTOR_H_ */
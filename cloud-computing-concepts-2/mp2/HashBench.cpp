@@ -0,0 +1,151 @@
+/**********************************
+ * FILE NAME: HashBench.cpp
+ *
+ * DESCRIPTION: Microbenchmark of the FlatTable behind HashTable against std::map, from
+ * 				10^3 keys up. Build with "make bench" and run ./HashBench [maxKeys]
+ **********************************/
+
+#include "FlatTable.h"
+#include <chrono>
+#include <malloc.h>
+
+/**
+ * Macros
+ */
+#define BENCH_MAX_KEYS 10000000
+// Lookups timed per table size, at least one per key
+#define BENCH_LOOKUPS 2000000
+// Keys are 5 characters, as Application makes them
+#define BENCH_KEY_LENGTH 5
+
+static const char alphanum[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+
+/**
+ * Result sink, so that the work being timed is not optimized away
+ */
+static size_t sink = 0;
+
+/**
+ * STRUCT NAME: BenchResult
+ *
+ * DESCRIPTION: Memory and times per key of one table at one size
+ */
+typedef struct BenchResult {
+    double bytesPerKey;
+    double insertNs;
+    double hitNs;
+    double missNs;
+    double scanNs;
+} BenchResult;
+
+/**
+ * FUNCTION NAME: makeKey
+ *
+ * DESCRIPTION: The distinct key of index i
+ */
+static string makeKey(size_t i) {
+    string key(BENCH_KEY_LENGTH, '0');
+    for (int at = 0; at < BENCH_KEY_LENGTH; at++) {
+        key[at] = alphanum[i % 62];
+        i /= 62;
+    }
+    return key;
+}
+
+/**
+ * FUNCTION NAME: heapInUse
+ *
+ * DESCRIPTION: Bytes allocated from the heap and by mmap, malloc overhead included
+ */
+static size_t heapInUse() {
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+/**
+ * FUNCTION NAME: since
+ *
+ * DESCRIPTION: Nanoseconds since start, per operation
+ */
+static double since(std::chrono::steady_clock::time_point start, size_t operations) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / operations;
+}
+
+/**
+ * FUNCTION NAME: run
+ *
+ * DESCRIPTION: Fill a table of type Table with keys, then time lookups of present keys in
+ * 				random order, of absent keys, and a scan of every entry
+ */
+template <typename Table>
+static BenchResult run(const vector<string> &keys, const vector<string> &absent, const vector<size_t> &order) {
+    BenchResult result;
+    size_t lookups = std::max(keys.size(), (size_t) BENCH_LOOKUPS);
+    size_t before = heapInUse();
+    Table table;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < keys.size(); i++) {
+        table.emplace(keys[i], "value" + to_string(i % 100));
+    }
+    result.insertNs = since(start, keys.size());
+    result.bytesPerKey = (double) (heapInUse() - before) / keys.size();
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups; i++) {
+        sink += table.find(keys[order[i % order.size()]])->second.size();
+    }
+    result.hitNs = since(start, lookups);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups; i++) {
+        sink += table.count(absent[i % absent.size()]);
+    }
+    result.missNs = since(start, lookups);
+
+    start = std::chrono::steady_clock::now();
+    for (auto it = table.begin(); it != table.end(); ++it) {
+        sink += it->first[0];
+    }
+    result.scanNs = since(start, keys.size());
+    return result;
+}
+
+/**
+ * FUNCTION NAME: report
+ *
+ * DESCRIPTION: Print the results of one table at one size
+ */
+static void report(const char *name, size_t keys, const BenchResult &result) {
+    printf("%-10s %9zu %10.1f %10.1f %10.1f %10.1f %10.1f\n", name, keys, result.bytesPerKey, result.insertNs,
+           result.hitNs, result.missNs, result.scanNs);
+}
+
+/**********************************
+ * FUNCTION NAME: main
+ *
+ * DESCRIPTION: Compare both tables at 10^3, 10^4, ... up to maxKeys keys
+ **********************************/
+int main(int argc, char *argv[]) {
+    size_t maxKeys = argc > 1 ? atol(argv[1]) : BENCH_MAX_KEYS;
+    std::mt19937_64 rng(42);
+    printf("%-10s %9s %10s %10s %10s %10s %10s\n", "table", "keys", "bytes/key", "insert ns", "hit ns", "miss ns",
+           "scan ns");
+    for (size_t n = 1000; n <= maxKeys; n *= 10) {
+        vector<string> keys;
+        vector<string> absent;
+        vector<size_t> order;
+        for (size_t i = 0; i < n; i++) {
+            keys.push_back(makeKey(i));
+            order.push_back(i);
+        }
+        for (size_t i = n; i < n + std::min(n, (size_t) BENCH_LOOKUPS); i++) {
+            absent.push_back(makeKey(i));
+        }
+        std::shuffle(order.begin(), order.end(), rng);
+
+        report("std::map", n, run<map<string, string, std::less<>>>(keys, absent, order));
+        report("FlatTable", n, run<FlatTable>(keys, absent, order));
+    }
+    return sink == 0;
+}
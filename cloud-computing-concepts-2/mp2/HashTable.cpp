@@ -17,11 +17,10 @@ HashTable::~HashTable() {}
  *
  * RETURNS:
  * true on SUCCESS
- * false in FAILURE
+ * false in FAILURE, when the key is already there
  */
-bool HashTable::create(string key, string value) {
-    hashTable.emplace(key, value);
-    return true;
+bool HashTable::create(string_view key, string_view value) {
+    return hashTable.emplace(key, value).second;
 }
 
 /**
@@ -33,16 +32,28 @@ bool HashTable::create(string key, string value) {
  * string value if found
  * else it returns a NULL
  */
-string HashTable::read(string key) {
-    map<string, string>::iterator search;
+string HashTable::read(string_view key) {
+    return string(find(key));
+}
 
-    search = hashTable.find(key);
+/**
+ * FUNCTION NAME: find
+ *
+ * DESCRIPTION: This function searches for the key in the hash table, without copying
+ * 				the value out
+ *
+ * RETURNS:
+ * view of the value if found, valid until the hash table is next written
+ * else it returns an empty view
+ */
+string_view HashTable::find(string_view key) {
+    auto search = hashTable.find(key);
     if (search != hashTable.end()) {
         // Value found
         return search->second;
     } else {
         // Value not found
-        return "";
+        return string_view();
     }
 }
 
@@ -56,16 +67,15 @@ string HashTable::read(string key) {
  * true on SUCCESS
  * false on FAILURE
  */
-bool HashTable::update(string key, string newValue) {
-    map<string, string>::iterator update;
+bool HashTable::update(string_view key, string_view newValue) {
+    auto update = hashTable.find(key);
 
-    if (read(key).empty()) {
+    if (update == hashTable.end() || update->second.empty()) {
         // Key not found
         return false;
     }
     // Key found
-    //update = hashTable.at(key) = newValue;
-    hashTable.at(key) = newValue;
+    hashTable.assign(update, newValue);
     // Update successful
     return true;
 }
@@ -79,18 +89,14 @@ bool HashTable::update(string key, string newValue) {
  * true on SUCCESS
  * false on FAILURE
  */
-bool HashTable::deleteKey(string key) {
-    uint eraseCount = 0;
+bool HashTable::deleteKey(string_view key) {
+    auto search = hashTable.find(key);
 
-    if (read(key).empty()) {
+    if (search == hashTable.end() || search->second.empty()) {
         // Key not found
         return false;
     }
-    eraseCount = hashTable.erase(key);
-    if (eraseCount < 1) {
-        // Could not erase
-        return false;
-    }
+    hashTable.erase(search);
     // Delete was successful
     return true;
 }
@@ -137,7 +143,16 @@ void HashTable::clear() {
  * RETURNS:
  * unsigned long count (Should be always 1)
  */
-unsigned long HashTable::count(string key) {
+unsigned long HashTable::count(string_view key) {
     return (unsigned long) hashTable.count(key);
 }
 
+
+/**
+ * FUNCTION NAME: addUsage
+ *
+ * DESCRIPTION: Add the memory taken by the hash table to usage
+ */
+void HashTable::addUsage(TableUsage &usage) const {
+    hashTable.addUsage(usage);
+}
@@ -13,27 +13,31 @@
 #include "stdincludes.h"
 #include "common.h"
 #include "Entry.h"
+#include "FlatTable.h"
 
 /**
  * CLASS NAME: HashTable
  *
- * DESCRIPTION: This class is a wrapper to the map provided by C++ STL.
+ * DESCRIPTION: This class is a wrapper to the open-addressing FlatTable. Keys are
+ * 				looked up by view without a copy.
  *
  */
 class HashTable {
 public:
-    map <string, string> hashTable;
+    FlatTable hashTable;
 
 //public:
     HashTable();
 
-    bool create(string key, string value);
+    bool create(string_view key, string_view value);
 
-    string read(string key);
+    string read(string_view key);
 
-    bool update(string key, string newValue);
+    string_view find(string_view key);
 
-    bool deleteKey(string key);
+    bool update(string_view key, string_view newValue);
+
+    bool deleteKey(string_view key);
 
     bool isEmpty();
 
@@ -41,7 +45,9 @@ public:
 
     void clear();
 
-    unsigned long count(string key);
+    unsigned long count(string_view key);
+
+    void addUsage(TableUsage &usage) const;
 
     virtual ~HashTable();
 };
@@ -0,0 +1,212 @@
+/**********************************
+ * FILE NAME: KeyFilter.cpp
+ *
+ * DESCRIPTION: KeyFilter class definition
+ **********************************/
+
+#include "KeyFilter.h"
+#include "Node.h"
+
+/**
+ * Constructor
+ */
+KeyFilter::KeyFilter() {
+    clear();
+}
+
+/**
+ * Destructor
+ */
+KeyFilter::~KeyFilter() {}
+
+/**
+ * FUNCTION NAME: cell
+ *
+ * DESCRIPTION: Returns the i-th cell of an entry in a filter of cells cells, by double
+ * 				hashing
+ */
+size_t KeyFilter::cell(uint64_t hash, int i, size_t cells) {
+    uint64_t step = Node::mixHash(hash) | 1;
+    return (size_t) ((hash + i * step) & (cells - 1));
+}
+
+/**
+ * FUNCTION NAME: count
+ *
+ * DESCRIPTION: Count the entry of hash in the cells of range. A saturated cell stays set
+ */
+void KeyFilter::count(FilterRange &range, uint64_t hash) {
+    for (int i = 0; i < FILTER_HASHES; i++) {
+        uint8_t &count = range.counts[cell(hash, i, range.counts.size())];
+        if (count < UINT8_MAX) {
+            count++;
+        }
+    }
+}
+
+/**
+ * FUNCTION NAME: add
+ *
+ * DESCRIPTION: Count the entry of hash, at ring position pos. The filter of an empty range
+ * 				is allocated first
+ *
+ * RETURNS:
+ * true if the range now has too many entries for its filter, which should be rebuilt
+ */
+bool KeyFilter::add(size_t pos, uint64_t hash) {
+    FilterRange &range = ranges[KeyVersions::rangeOf(pos)];
+    if (range.counts.empty()) {
+        range.counts.assign(FILTER_MIN_CELLS, 0);
+    }
+    count(range, hash);
+    range.entries++;
+    return range.counts.size() < FILTER_MAX_CELLS && range.entries * FILTER_CELLS_PER_KEY > range.counts.size();
+}
+
+/**
+ * FUNCTION NAME: remove
+ *
+ * DESCRIPTION: Uncount the entry of hash, at ring position pos, which was added before.
+ * 				The filter of a range left empty is freed
+ */
+void KeyFilter::remove(size_t pos, uint64_t hash) {
+    FilterRange &range = ranges[KeyVersions::rangeOf(pos)];
+    if (range.entries == 0) {
+        return;
+    }
+    if (--range.entries == 0) {
+        vector<uint8_t>().swap(range.counts);
+        return;
+    }
+    for (int i = 0; i < FILTER_HASHES; i++) {
+        uint8_t &count = range.counts[cell(hash, i, range.counts.size())];
+        if (count > 0 && count < UINT8_MAX) {
+            count--;
+        }
+    }
+}
+
+/**
+ * FUNCTION NAME: rebuild
+ *
+ * DESCRIPTION: Count anew the entries of range, given by their hashes, in a filter sized
+ * 				for them
+ */
+void KeyFilter::rebuild(size_t range, const vector <uint64_t> &hashes) {
+    FilterRange &filter = ranges[range];
+    if (hashes.empty()) {
+        vector<uint8_t>().swap(filter.counts);
+        filter.entries = 0;
+        return;
+    }
+    size_t cells = FILTER_MIN_CELLS;
+    while (cells < FILTER_MAX_CELLS && cells < hashes.size() * FILTER_CELLS_PER_KEY) {
+        cells *= 2;
+    }
+    filter.counts.assign(cells, 0);
+    filter.entries = hashes.size();
+    std::for_each(hashes.begin(), hashes.end(), [&filter](uint64_t hash) {
+        count(filter, hash);
+    });
+}
+
+/**
+ * FUNCTION NAME: bitsSize
+ *
+ * DESCRIPTION: Returns the bytes appendBits takes for the filter of range
+ */
+size_t KeyFilter::bitsSize(size_t range) const {
+    return sizeof(uint16_t) + ranges[range].counts.size() / 8;
+}
+
+/**
+ * FUNCTION NAME: appendBits
+ *
+ * DESCRIPTION: Append to out the filter of range, a bit per cell, after its byte count as
+ * 				a uint16. An empty range has no bits
+ */
+void KeyFilter::appendBits(size_t range, string &out) const {
+    const vector <uint8_t> &cells = ranges[range].counts;
+    uint16_t size = (uint16_t) (cells.size() / 8);
+    out.append((const char *) &size, sizeof(size));
+    for (size_t byte = 0; byte < size; byte++) {
+        uint8_t bits = 0;
+        for (int bit = 0; bit < 8; bit++) {
+            bits |= (uint8_t) (cells[byte * 8 + bit] != 0) << bit;
+        }
+        out.push_back((char) bits);
+    }
+}
+
+/**
+ * FUNCTION NAME: nextBits
+ *
+ * DESCRIPTION: Read the first filter of filters, as appendBits wrote it, into bits and
+ * 				take it off filters
+ *
+ * RETURNS:
+ * false if filters holds no whole filter
+ */
+bool KeyFilter::nextBits(string_view &filters, string_view &bits) {
+    uint16_t size;
+    if (filters.size() < sizeof(size)) {
+        return false;
+    }
+    memcpy(&size, filters.data(), sizeof(size));
+    if (filters.size() - sizeof(size) < size) {
+        return false;
+    }
+    bits = filters.substr(sizeof(size), size);
+    filters.remove_prefix(sizeof(size) + size);
+    return true;
+}
+
+/**
+ * FUNCTION NAME: mayContain
+ *
+ * DESCRIPTION: Whether the filter bits of a range may hold the entry of hash. False means
+ * 				it surely does not; the filter of an empty range holds nothing
+ */
+bool KeyFilter::mayContain(string_view bits, uint64_t hash) {
+    if (bits.empty()) {
+        return false;
+    }
+    for (int i = 0; i < FILTER_HASHES; i++) {
+        size_t at = cell(hash, i, bits.size() * 8);
+        if (!((uint8_t) bits[at / 8] & (1 << (at % 8)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * FUNCTION NAME: digestOf
+ *
+ * DESCRIPTION: Returns the digest of an entry a replica confirms it holds: the high half
+ * 				of its hash, so a key passing the filter by chance is still unlikely to
+ * 				match a digest
+ */
+uint32_t KeyFilter::digestOf(uint64_t hash) {
+    return (uint32_t) (hash >> 32);
+}
+
+/**
+ * FUNCTION NAME: rangeBounds
+ *
+ * DESCRIPTION: Ring positions (lo, hi] of range, as the key index takes them
+ */
+void KeyFilter::rangeBounds(size_t range, size_t &lo, size_t &hi) {
+    size_t width = SIZE_MAX / VERSION_RANGES + 1;
+    lo = range * width - 1;
+    hi = (range + 1) * width - 1;
+}
+
+/**
+ * FUNCTION NAME: clear
+ *
+ * DESCRIPTION: Empty every filter, freeing its cells
+ */
+void KeyFilter::clear() {
+    ranges.assign(VERSION_RANGES, FilterRange());
+}
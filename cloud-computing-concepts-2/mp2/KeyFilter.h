@@ -0,0 +1,135 @@
+/**********************************
+ * FILE NAME: KeyFilter.h
+ *
+ * DESCRIPTION: Header file of KeyFilter class
+ **********************************/
+
+#ifndef KEYFILTER_H_
+#define KEYFILTER_H_
+
+#include "stdincludes.h"
+#include "Member.h"
+#include "KeyVersions.h"
+#include "RangeTransfer.h"
+
+/**
+ * Macros
+ */
+// Cells a key takes at least in the filter of its ring range, which at 4 cells set a key
+// keeps false positives under 2 in 100. A filter is allocated with the first key of its
+// range and doubles as the range fills, from FILTER_MIN_CELLS up to FILTER_MAX_CELLS,
+// whose bits still fit a message; past FILTER_MAX_CELLS / FILTER_CELLS_PER_KEY keys a
+// range gets more false positives, which the digests sort out
+#define FILTER_CELLS_PER_KEY 10
+#define FILTER_MIN_CELLS 512
+#define FILTER_MAX_CELLS 16384
+#define FILTER_HASHES 4
+// Bytes of the digest confirming a key a filter says a replica may hold
+#define FILTER_DIGEST_SIZE sizeof(uint32_t)
+
+/**
+ * What to do with a key offered to a replica
+ */
+enum OfferVerdict {
+    OFFER_UNDECIDED,
+    OFFER_SEND,
+    OFFER_CONFIRM,
+    OFFER_SKIP
+};
+
+/**
+ * STRUCT NAME: KeyOffer
+ *
+ * DESCRIPTION: Keys the stabilization protocol would send a replica, held back until the
+ * 				filters of the replica say which it probably has already. Those are
+ * 				confirmed by a digest of their entries, in chunks of perChunk, before
+ * 				being left out; the others are sent at once
+ */
+typedef struct KeyOffer {
+    Address to;
+    vector <TransferKey> keys;
+    vector <uint8_t> verdicts;
+    // Ranges whose filters are awaited
+    uint64_t ranges;
+    // Keys to confirm, as indices in keys, and the chunks of them not answered yet
+    vector <size_t> confirming;
+    size_t perChunk;
+    size_t chunksPending;
+    int lastProgress;
+} KeyOffer;
+
+/**
+ * STRUCT NAME: FilterStats
+ *
+ * DESCRIPTION: Keys offered to replicas by one or more nodes, and what the filters saved
+ */
+typedef struct FilterStats {
+    long offered;
+    long skipped;
+    // bytes the records of the skipped keys would have taken
+    long skippedBytes;
+    long confirmed;
+    // filter and digest messages, and their bytes
+    long messages;
+    long bytes;
+    // offers whose replica did not answer, their keys sent in full
+    long expired;
+} FilterStats;
+
+/**
+ * STRUCT NAME: FilterRange
+ *
+ * DESCRIPTION: The counting filter of a ring range, a power of two cells, none while the
+ * 				range is empty, and the entries counted in it
+ */
+typedef struct FilterRange {
+    vector <uint8_t> counts;
+    size_t entries;
+} FilterRange;
+
+/**
+ * CLASS NAME: KeyFilter
+ *
+ * DESCRIPTION: Counting Bloom filters of the entries held by a node, one per ring range of
+ * 				KeyVersions, sized from the keys of the range. An entry is the hash of a key
+ * 				and its value, so a replica holding an older value does not pass for holding
+ * 				the key. Cells count the entries hashing to them, so writes and deletes
+ * 				update the filter in place; a filter sent to another node only carries
+ * 				whether each cell is set. A filter outgrown by its range is rebuilt larger
+ * 				from the entries of the range, which only the store has
+ */
+class KeyFilter {
+private:
+    vector <FilterRange> ranges;
+
+    static size_t cell(uint64_t hash, int i, size_t cells);
+
+    static void count(FilterRange &range, uint64_t hash);
+
+public:
+    KeyFilter();
+
+    bool add(size_t pos, uint64_t hash);
+
+    void remove(size_t pos, uint64_t hash);
+
+    void rebuild(size_t range, const vector <uint64_t> &hashes);
+
+    size_t bitsSize(size_t range) const;
+
+    void appendBits(size_t range, string &out) const;
+
+    static bool nextBits(string_view &filters, string_view &bits);
+
+    static bool mayContain(string_view bits, uint64_t hash);
+
+    static uint32_t digestOf(uint64_t hash);
+
+    static void rangeBounds(size_t range, size_t &lo, size_t &hi);
+
+    void clear();
+
+    virtual ~KeyFilter();
+};
+
+#endif /* KEYFILTER_H_ */
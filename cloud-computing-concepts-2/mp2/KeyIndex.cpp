@@ -0,0 +1,93 @@
+/**********************************
+ * FILE NAME: KeyIndex.cpp
+ *
+ * DESCRIPTION: KeyIndex class definition
+ **********************************/
+
+#include "KeyIndex.h"
+
+/**
+ * Constructor
+ */
+KeyIndex::KeyIndex() {}
+
+/**
+ * Destructor
+ */
+KeyIndex::~KeyIndex() {}
+
+/**
+ * FUNCTION NAME: insert
+ *
+ * DESCRIPTION: Add key, at ring position pos. The caller adds each key once
+ */
+void KeyIndex::insert(string_view key, size_t pos) {
+    keys.emplace(pos, string(key));
+}
+
+/**
+ * FUNCTION NAME: erase
+ *
+ * DESCRIPTION: Remove key, at ring position pos, if it is there
+ */
+void KeyIndex::erase(string_view key, size_t pos) {
+    auto range = keys.equal_range(pos);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == key) {
+            keys.erase(it);
+            return;
+        }
+    }
+}
+
+/**
+ * FUNCTION NAME: keysIn
+ *
+ * DESCRIPTION: Append the keys at ring positions (from, to], wrapping around, to out in
+ * 				ring order, with their positions. from == to is the whole ring, from
+ * 				position 0. Past limit keys, only those at the position of the last one
+ * 				are appended, so that a caller may resume after that position
+ *
+ * RETURNS:
+ * true if every key of the range was appended
+ */
+bool KeyIndex::keysIn(size_t from, size_t to, vector<pair<size_t, string>> &out, size_t limit) {
+    auto it = from == to ? keys.begin() : keys.upper_bound(from);
+    auto last = from == to ? keys.end() : keys.upper_bound(to);
+    bool wrapping = from > to;
+    size_t taken = 0;
+    while (true) {
+        if (it == (wrapping ? keys.end() : last)) {
+            if (!wrapping) {
+                return true;
+            }
+            wrapping = false;
+            it = keys.begin();
+            continue;
+        }
+        if (taken >= limit && (taken == 0 || it->first != out.back().first)) {
+            return false;
+        }
+        out.push_back(*it);
+        ++it;
+        taken++;
+    }
+}
+
+/**
+ * FUNCTION NAME: size
+ *
+ * DESCRIPTION: Returns the number of keys
+ */
+size_t KeyIndex::size() {
+    return keys.size();
+}
+
+/**
+ * FUNCTION NAME: clear
+ *
+ * DESCRIPTION: Remove every key
+ */
+void KeyIndex::clear() {
+    keys.clear();
+}
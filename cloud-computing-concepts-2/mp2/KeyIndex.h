@@ -0,0 +1,40 @@
+/**********************************
+ * FILE NAME: KeyIndex.h
+ *
+ * DESCRIPTION: Header file of KeyIndex class
+ **********************************/
+
+#ifndef KEYINDEX_H_
+#define KEYINDEX_H_
+
+#include "stdincludes.h"
+
+/**
+ * CLASS NAME: KeyIndex
+ *
+ * DESCRIPTION: The keys held by the key-value store ordered by their ring position, which
+ * 				is kept next to each key. The keys of a range of the ring are enumerated
+ * 				without going through the others, so that moving a range costs in
+ * 				proportion to the keys in it.
+ */
+class KeyIndex {
+private:
+    multimap<size_t, string> keys;
+
+public:
+    KeyIndex();
+
+    void insert(string_view key, size_t pos);
+
+    void erase(string_view key, size_t pos);
+
+    bool keysIn(size_t from, size_t to, vector<pair<size_t, string>> &out, size_t limit = SIZE_MAX);
+
+    size_t size();
+
+    void clear();
+
+    virtual ~KeyIndex();
+};
+
+#endif /* KEYINDEX_H_ */
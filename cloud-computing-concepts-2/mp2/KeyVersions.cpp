@@ -0,0 +1,132 @@
+/**********************************
+ * FILE NAME: KeyVersions.cpp
+ *
+ * DESCRIPTION: KeyVersions class definition
+ **********************************/
+
+#include "KeyVersions.h"
+
+/**
+ * Constructor
+ */
+KeyVersions::KeyVersions() {
+    clear();
+}
+
+/**
+ * Destructor
+ */
+KeyVersions::~KeyVersions() {}
+
+/**
+ * FUNCTION NAME: rangeOf
+ *
+ * DESCRIPTION: Returns the range holding ring position pos
+ */
+size_t KeyVersions::rangeOf(size_t pos) {
+    return pos / (SIZE_MAX / VERSION_RANGES + 1);
+}
+
+/**
+ * FUNCTION NAME: touch
+ *
+ * DESCRIPTION: Record a write to key, at ring position pos, made at round stamp
+ */
+void KeyVersions::touch(string_view key, size_t pos, long stamp, bool deleted) {
+    VersionRange &range = ranges[rangeOf(pos)];
+    auto it = range.keys.find(key);
+    if (it == range.keys.end()) {
+        it = range.keys.emplace(key, KeyVersion()).first;
+    }
+    KeyVersion &version = it->second;
+    version.stamp = stamp;
+    version.deleted = deleted;
+    range.version = std::max(range.version, stamp);
+}
+
+/**
+ * FUNCTION NAME: forget
+ *
+ * DESCRIPTION: Drop a key this node no longer holds a replica of. Unlike a delete, this
+ * 				leaves no tombstone
+ */
+void KeyVersions::forget(string_view key, size_t pos) {
+    VersionRange &range = ranges[rangeOf(pos)];
+    auto it = range.keys.find(key);
+    if (it != range.keys.end()) {
+        range.keys.erase(it);
+    }
+}
+
+/**
+ * FUNCTION NAME: find
+ *
+ * DESCRIPTION: Returns the version of key, NULL if it was never written here
+ */
+const KeyVersion *KeyVersions::find(string_view key, size_t pos) {
+    VersionRange &range = ranges[rangeOf(pos)];
+    auto it = range.keys.find(key);
+    return it == range.keys.end() ? NULL : &it->second;
+}
+
+/**
+ * FUNCTION NAME: changedSince
+ *
+ * DESCRIPTION: Append the keys of a range written after round since to out
+ */
+void KeyVersions::changedSince(size_t range, long since, vector<pair<string, KeyVersion>> &out) {
+    if (ranges[range].version <= since) {
+        return;
+    }
+    map<string, KeyVersion, std::less<>> &keys = ranges[range].keys;
+    std::copy_if(keys.begin(), keys.end(), std::back_inserter(out), [since](const pair<string, KeyVersion> &kv) {
+        return kv.second.stamp > since;
+    });
+}
+
+/**
+ * FUNCTION NAME: dropTombstones
+ *
+ * DESCRIPTION: Drop the tombstones of the deletes made before round horizon, and those of
+ * 				the keys ours says this node no longer holds a replica of. Range versions
+ * 				are left as they are
+ *
+ * RETURNS:
+ * the number of tombstones dropped
+ */
+size_t KeyVersions::dropTombstones(long horizon, const function<bool(string_view)> &ours) {
+    size_t dropped = 0;
+    std::for_each(ranges.begin(), ranges.end(), [&](VersionRange &range) {
+        auto it = range.keys.begin();
+        while (it != range.keys.end()) {
+            if (it->second.deleted && (it->second.stamp < horizon || !ours(it->first))) {
+                it = range.keys.erase(it);
+                dropped++;
+            } else {
+                ++it;
+            }
+        }
+    });
+    return dropped;
+}
+
+/**
+ * FUNCTION NAME: getVersion
+ *
+ * DESCRIPTION: Returns the round of the last write to a range, -1 if none
+ */
+long KeyVersions::getVersion(size_t range) {
+    return ranges[range].version;
+}
+
+/**
+ * FUNCTION NAME: clear
+ *
+ * DESCRIPTION: Forget every key and version
+ */
+void KeyVersions::clear() {
+    ranges.assign(VERSION_RANGES, VersionRange());
+    std::for_each(ranges.begin(), ranges.end(), [](VersionRange &range) {
+        range.version = -1;
+    });
+}
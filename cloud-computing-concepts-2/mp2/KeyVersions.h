@@ -0,0 +1,73 @@
+/**********************************
+ * FILE NAME: KeyVersions.h
+ *
+ * DESCRIPTION: Header file of KeyVersions class
+ **********************************/
+
+#ifndef KEYVERSIONS_H_
+#define KEYVERSIONS_H_
+
+#include "stdincludes.h"
+
+/**
+ * Macros
+ */
+// Number of ring ranges versioned separately, a power of two
+#define VERSION_RANGES 64
+
+/**
+ * STRUCT NAME: KeyVersion
+ *
+ * DESCRIPTION: Round at which a key was last written on this node, and whether that
+ * 				write was a delete
+ */
+typedef struct KeyVersion {
+    long stamp;
+    bool deleted;
+} KeyVersion;
+
+/**
+ * STRUCT NAME: VersionRange
+ *
+ * DESCRIPTION: The keys of one ring range and the round of the last write to any of them
+ */
+typedef struct VersionRange {
+    long version;
+    map<string, KeyVersion, std::less<>> keys;
+} VersionRange;
+
+/**
+ * CLASS NAME: KeyVersions
+ *
+ * DESCRIPTION: When each key held by the key-value store last changed, grouped by the
+ * 				range of the ring it hashes to. Deletes are kept as tombstones so that they
+ * 				are passed on too, until they are older than a horizon. A range whose version is not newer than a given round
+ * 				holds no change since then and is skipped as a whole.
+ */
+class KeyVersions {
+private:
+    vector<VersionRange> ranges;
+
+public:
+    KeyVersions();
+
+    static size_t rangeOf(size_t pos);
+
+    void touch(string_view key, size_t pos, long stamp, bool deleted);
+
+    void forget(string_view key, size_t pos);
+
+    const KeyVersion *find(string_view key, size_t pos);
+
+    void changedSince(size_t range, long since, vector<pair<string, KeyVersion>> &out);
+
+    size_t dropTombstones(long horizon, const function<bool(string_view)> &ours);
+
+    long getVersion(size_t range);
+
+    void clear();
+
+    virtual ~KeyVersions();
+};
+
+#endif /* KEYVERSIONS_H_ */
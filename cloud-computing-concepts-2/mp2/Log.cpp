@@ -125,7 +125,7 @@ void Log::logNodeAdd(Address *thisNode, Address *addedAddr) {
  * DESCRIPTION: To log a node remove
  */
 void Log::logNodeRemove(Address *thisNode, Address *removedAddr) {
-    static char stdstring[30];
+    static char stdstring[100];
     sprintf(stdstring, "Node %d.%d.%d.%d:%d removed at time %d", removedAddr->addr[0], removedAddr->addr[1],
             removedAddr->addr[2], removedAddr->addr[3], *(short *) &removedAddr->addr[4], par->getcurrtime());
     LOG(thisNode, stdstring);
@@ -136,15 +136,15 @@ void Log::logNodeRemove(Address *thisNode, Address *removedAddr) {
  *
  * DESCRTION: Call this function after successfully create a key value pair
  */
-void Log::logCreateSuccess(Address *address, bool isCoordinator, int transID, string key, string value) {
+void Log::logCreateSuccess(Address *address, bool isCoordinator, int transID, string_view key, string_view value) {
     static char stdstring[100];
     string str;
     if (isCoordinator)
         str = "coordinator";
     else
         str = "server";
-    sprintf(stdstring, "%s: create success at time %d, transID=%d, key=%s, value=%s", str.c_str(), par->getcurrtime(),
-            transID, key.c_str(), value.c_str());
+    snprintf(stdstring, sizeof(stdstring), "%s: create success at time %d, transID=%d, key=%.*s, value=%.*s",
+             str.c_str(), par->getcurrtime(), transID, (int) key.size(), key.data(), (int) value.size(), value.data());
     LOG(address, stdstring);
 }
 
@@ -153,15 +153,15 @@ void Log::logCreateSuccess(Address *address, bool isCoordinator, int transID, st
  *
  * DESCRIPTION: Call this function after successfully reading a key
  */
-void Log::logReadSuccess(Address *address, bool isCoordinator, int transID, string key, string value) {
+void Log::logReadSuccess(Address *address, bool isCoordinator, int transID, string_view key, string_view value) {
     static char stdstring[100];
     string str;
     if (isCoordinator)
         str = "coordinator";
     else
         str = "server";
-    sprintf(stdstring, "%s: read success at time %d, transID=%d, key=%s, value=%s", str.c_str(), par->getcurrtime(),
-            transID, key.c_str(), value.c_str());
+    snprintf(stdstring, sizeof(stdstring), "%s: read success at time %d, transID=%d, key=%.*s, value=%.*s",
+             str.c_str(), par->getcurrtime(), transID, (int) key.size(), key.data(), (int) value.size(), value.data());
     LOG(address, stdstring);
 }
 
@@ -170,15 +170,16 @@ void Log::logReadSuccess(Address *address, bool isCoordinator, int transID, stri
  *
  * DESCRIPTION: Call this function after successfully updating a key
  */
-void Log::logUpdateSuccess(Address *address, bool isCoordinator, int transID, string key, string newValue) {
+void Log::logUpdateSuccess(Address *address, bool isCoordinator, int transID, string_view key, string_view newValue) {
     static char stdstring[100];
     string str;
     if (isCoordinator)
         str = "coordinator";
     else
         str = "server";
-    sprintf(stdstring, "%s: update success at time %d, transID=%d, key=%s, value=%s", str.c_str(), par->getcurrtime(),
-            transID, key.c_str(), newValue.c_str());
+    snprintf(stdstring, sizeof(stdstring), "%s: update success at time %d, transID=%d, key=%.*s, value=%.*s",
+             str.c_str(), par->getcurrtime(), transID, (int) key.size(), key.data(),
+             (int) newValue.size(), newValue.data());
     LOG(address, stdstring);
 }
 
@@ -187,15 +188,15 @@ void Log::logUpdateSuccess(Address *address, bool isCoordinator, int transID, st
  *
  * DESCRIPTION: Call this function after successfully deleting a key
  */
-void Log::logDeleteSuccess(Address *address, bool isCoordinator, int transID, string key) {
+void Log::logDeleteSuccess(Address *address, bool isCoordinator, int transID, string_view key) {
     static char stdstring[100];
     string str;
     if (isCoordinator)
         str = "coordinator";
     else
         str = "server";
-    sprintf(stdstring, "%s: delete success at time %d, transID=%d, key=%s", str.c_str(), par->getcurrtime(), transID,
-            key.c_str());
+    snprintf(stdstring, sizeof(stdstring), "%s: delete success at time %d, transID=%d, key=%.*s",
+             str.c_str(), par->getcurrtime(), transID, (int) key.size(), key.data());
     LOG(address, stdstring);
 }
 
@@ -204,15 +205,15 @@ void Log::logDeleteSuccess(Address *address, bool isCoordinator, int transID, st
  *
  * DESCRIPTION: Call this function if CREATE failed
  */
-void Log::logCreateFail(Address *address, bool isCoordinator, int transID, string key, string value) {
+void Log::logCreateFail(Address *address, bool isCoordinator, int transID, string_view key, string_view value) {
     static char stdstring[100];
     string str;
     if (isCoordinator)
         str = "coordinator";
     else
         str = "server";
-    sprintf(stdstring, "%s: create fail at time %d, transID=%d, key=%s, value=%s", str.c_str(), par->getcurrtime(),
-            transID, key.c_str(), value.c_str());
+    snprintf(stdstring, sizeof(stdstring), "%s: create fail at time %d, transID=%d, key=%.*s, value=%.*s",
+             str.c_str(), par->getcurrtime(), transID, (int) key.size(), key.data(), (int) value.size(), value.data());
     LOG(address, stdstring);
 }
 
@@ -222,15 +223,15 @@ void Log::logCreateFail(Address *address, bool isCoordinator, int transID, strin
  *
  * DESCRIPTION: Call this function if READ failed
  */
-void Log::logReadFail(Address *address, bool isCoordinator, int transID, string key) {
+void Log::logReadFail(Address *address, bool isCoordinator, int transID, string_view key) {
     static char stdstring[100];
     string str;
     if (isCoordinator)
         str = "coordinator";
     else
         str = "server";
-    sprintf(stdstring, "%s: read fail at time %d, transID=%d, key=%s", str.c_str(), par->getcurrtime(), transID,
-            key.c_str());
+    snprintf(stdstring, sizeof(stdstring), "%s: read fail at time %d, transID=%d, key=%.*s",
+             str.c_str(), par->getcurrtime(), transID, (int) key.size(), key.data());
     LOG(address, stdstring);
 }
 
@@ -239,15 +240,16 @@ void Log::logReadFail(Address *address, bool isCoordinator, int transID, string
  *
  * DESCRIPTION: Call this function if UPDATE failed
  */
-void Log::logUpdateFail(Address *address, bool isCoordinator, int transID, string key, string newValue) {
+void Log::logUpdateFail(Address *address, bool isCoordinator, int transID, string_view key, string_view newValue) {
     static char stdstring[100];
     string str;
     if (isCoordinator)
         str = "coordinator";
     else
         str = "server";
-    sprintf(stdstring, "%s: update fail at time %d, transID=%d, key=%s, value=%s", str.c_str(), par->getcurrtime(),
-            transID, key.c_str(), newValue.c_str());
+    snprintf(stdstring, sizeof(stdstring), "%s: update fail at time %d, transID=%d, key=%.*s, value=%.*s",
+             str.c_str(), par->getcurrtime(), transID, (int) key.size(), key.data(),
+             (int) newValue.size(), newValue.data());
     LOG(address, stdstring);
 }
 
@@ -256,14 +258,14 @@ void Log::logUpdateFail(Address *address, bool isCoordinator, int transID, strin
  *
  * DESCRIPTION: Call this function if DELETE failed
  */
-void Log::logDeleteFail(Address *address, bool isCoordinator, int transID, string key) {
+void Log::logDeleteFail(Address *address, bool isCoordinator, int transID, string_view key) {
     static char stdstring[100];
     string str;
     if (isCoordinator)
         str = "coordinator";
     else
         str = "server";
-    sprintf(stdstring, "%s: delete fail at time %d, transID=%d, key=%s", str.c_str(), par->getcurrtime(), transID,
-            key.c_str());
+    snprintf(stdstring, sizeof(stdstring), "%s: delete fail at time %d, transID=%d, key=%.*s",
+             str.c_str(), par->getcurrtime(), transID, (int) key.size(), key.data());
     LOG(address, stdstring);
 }
@@ -45,22 +45,22 @@ public:
     void logNodeRemove(Address *, Address *);
 
     // success
-    void logCreateSuccess(Address *address, bool isCoordinator, int transID, string key, string value);
+    void logCreateSuccess(Address *address, bool isCoordinator, int transID, string_view key, string_view value);
 
-    void logReadSuccess(Address *address, bool isCoordinator, int transID, string key, string value);
+    void logReadSuccess(Address *address, bool isCoordinator, int transID, string_view key, string_view value);
 
-    void logUpdateSuccess(Address *address, bool isCoordinator, int transID, string key, string newValue);
+    void logUpdateSuccess(Address *address, bool isCoordinator, int transID, string_view key, string_view newValue);
 
-    void logDeleteSuccess(Address *address, bool isCoordinator, int transID, string key);
+    void logDeleteSuccess(Address *address, bool isCoordinator, int transID, string_view key);
 
     // fail
-    void logCreateFail(Address *address, bool isCoordinator, int transID, string key, string value);
+    void logCreateFail(Address *address, bool isCoordinator, int transID, string_view key, string_view value);
 
-    void logReadFail(Address *address, bool isCoordinator, int transID, string key);
+    void logReadFail(Address *address, bool isCoordinator, int transID, string_view key);
 
-    void logUpdateFail(Address *address, bool isCoordinator, int transID, string key, string newValue);
+    void logUpdateFail(Address *address, bool isCoordinator, int transID, string_view key, string_view newValue);
 
-    void logDeleteFail(Address *address, bool isCoordinator, int transID, string key);
+    void logDeleteFail(Address *address, bool isCoordinator, int transID, string_view key);
 };
 
 #endif /* _LOG_H_ */
@@ -28,6 +28,22 @@ MP1Node::MP1Node(Member *member, Params *params, EmulNet *emul, Log *log, Addres
     this->log = log;
     this->par = params;
     this->memberNode->addr = *address;
+    this->liveMembers = 0;
+    this->membershipEpoch = 0;
+    this->gossipWindow = 0;
+    this->joinAttempts = 0;
+    this->joinSeedOffset = 0;
+    this->joinRequestTime = 0;
+    this->joinStartTime = -1;
+    this->joinedTime = -1;
+    this->joinsAnswered = 0;
+    this->joinReplyMsgs = 0;
+    this->joinReplyBytes = 0;
+    this->piggybackWindow = 0;
+    this->piggybacksSent = 0;
+    this->heartbeatsSuppressed = 0;
+    this->restarted = false;
+    this->gossip.seed(((unsigned long long) rand() << 32) ^ rand() ^ memberKey(getId(*address), getPort(*address)));
 }
 
 /**
@@ -68,6 +84,8 @@ int MP1Node::enqueueWrapper(void *env, char *buff, int size) {
  */
 void MP1Node::nodeStart(char *servaddrstr, short servport) {
     Address joinaddr;
+    joinAttempts = 0;
+    joinStartTime = par->getcurrtime();
     joinaddr = getJoinAddress();
 
     // Self booting routines
@@ -131,6 +149,7 @@ int MP1Node::introduceSelfToGroup(Address *joinaddr) {
         log->LOG(&memberNode->addr, "Starting up group...");
 #endif
         memberNode->inGroup = true;
+        joinedTime = par->getcurrtime();
     } else {
         size_t msgsize = sizeof(MessageHdr) + sizeof(joinaddr->addr) + sizeof(long) + 1;
         msg = (MessageHdr *) malloc(msgsize * sizeof(char));
@@ -147,6 +166,7 @@ int MP1Node::introduceSelfToGroup(Address *joinaddr) {
 
         // send JOINREQ message to introducer member
         emulNet->ENsend(&memberNode->addr, joinaddr, (char *) msg, msgsize);
+        joinRequestTime = par->getcurrtime();
 
         free(msg);
     }
@@ -161,9 +181,88 @@ int MP1Node::introduceSelfToGroup(Address *joinaddr) {
  * DESCRIPTION: Wind up this node and clean up state
  */
 int MP1Node::finishUpThisNode() {
-    /*
-     * Your code goes here
-     */
+    if (joinsAnswered > 0) {
+        log->LOG(&memberNode->addr, "#STATSLOG# introducer: answered %ld JOINREQs with %ld JOINREPs, %ld bytes",
+                 joinsAnswered, joinReplyMsgs, joinReplyBytes);
+    }
+    if (joinStartTime >= 0 && joinedTime >= 0) {
+        log->LOG(&memberNode->addr, "#STATSLOG# joined in %ld ticks, %d retries", joinedTime - joinStartTime,
+                 joinAttempts);
+    }
+    if (piggybacksSent > 0) {
+        log->LOG(&memberNode->addr, "#STATSLOG# piggybacked on %ld key-value messages, %ld heartbeats suppressed",
+                 piggybacksSent, heartbeatsSuppressed);
+    }
+    if (partialView()) {
+        log->LOG(&memberNode->addr, "#STATSLOG# partial view: %zu active, %zu passive, ring digest %zu/%zu at epoch %ld",
+                 memberNode->memberList.size() - 1, passiveView.size(), ringDigest.alive(), ringDigest.size(),
+                 ringDigest.getEpoch());
+    }
+    return 0;
+}
+
+/**
+ * FUNCTION NAME: leaveGroup
+ *
+ * DESCRIPTION: Leave the group gracefully. Our listeners are told first, while the ring
+ * 				still has us, so the key-value store can hand its keys off. Then every
+ * 				member gets a LEAVE, or with PARTIAL_VIEW every neighbour gets our RING_LEFT
+ * 				digest entry and a DISCONNECT, and the node stops.
+ */
+void MP1Node::leaveGroup() {
+    if (!memberNode->inGroup || memberNode->bFailed) {
+        return;
+    }
+    publish(MEMBER_LEFT, memberNode->addr);
+
+    std::vector <MemberListEntry> &list = memberNode->memberList;
+    if (partialView()) {
+        long epoch = ringDigest.getEpoch();
+        ringDigest.announce(list[0].id, list[0].port, RING_LEFT);
+        for (size_t i = 1; i < list.size(); i++) {
+            Address addr = getAddress(list[i].id, list[i].port);
+            pushDigest(addr, epoch);
+            sendView(DISCONNECT, addr, std::vector<MemberListEntry>(1, list[0]), 0);
+        }
+    } else {
+        MessageHdr *msg = newMessage(LEAVE, memberNode->addr, list.data(), 1);
+        for (size_t i = 1; i < list.size(); i++) {
+            Address addr = getAddress(list[i].id, list[i].port);
+            emulNet->ENsend(&memberNode->addr, &addr, (char *) msg, messageSize(1));
+        }
+        free(msg);
+    }
+    log->LOG(&memberNode->addr, "#STATSLOG# left the group, told %zu members", list.size() - 1);
+
+    memberNode->inGroup = false;
+    memberNode->bFailed = true;
+}
+
+/**
+ * FUNCTION NAME: rejoinGroup
+ *
+ * DESCRIPTION: Bring a node that went down back into the group. All membership state is
+ * 				rebuilt from a fresh JOINREQ, but the heartbeat carries on from where it
+ * 				stopped so that members still holding our old entry take the new one.
+ */
+void MP1Node::rejoinGroup() {
+    long heartbeat = memberNode->heartbeat;
+    pendingJoins.clear();
+    passiveView.clear();
+    ringDigest.clear();
+    departed.clear();
+    gossipWindow = 0;
+    piggybackWindow = 0;
+    restarted = true;
+
+    joinAttempts = 0;
+    joinStartTime = par->getcurrtime();
+    joinedTime = -1;
+    Address joinaddr = getJoinAddress();
+    initThisNode(&joinaddr);
+    memberNode->heartbeat = heartbeat + 1;
+    memberNode->memberList[0].heartbeat = memberNode->heartbeat;
+    introduceSelfToGroup(&joinaddr);
 }
 
 /**
@@ -182,6 +281,12 @@ void MP1Node::nodeLoop() {
 
     // Wait until you're in the group...
     if (!memberNode->inGroup) {
+        // ...asking the next seed if this one did not answer in time
+        if (par->getcurrtime() >= joinRequestTime + par->JOIN_TIMEOUT) {
+            joinAttempts++;
+            Address joinaddr = getJoinAddress();
+            introduceSelfToGroup(&joinaddr);
+        }
         return;
     }
 
@@ -211,25 +316,72 @@ void MP1Node::checkMessages() {
 }
 
 
-MessageHdr *MP1Node::newMessage(MsgTypes type, Address addr, vector <MemberListEntry> memberList) {
+/**
+ * FUNCTION NAME: newMessage
+ *
+ * DESCRIPTION: Build a message carrying count membership entries. Size is messageSize(count)
+ */
+MessageHdr *MP1Node::newMessage(MsgTypes type, Address addr, const MemberListEntry *entries, long count) {
+    return newMessage(type, addr, entries, count, NULL, 0);
+}
+
+/**
+ * FUNCTION NAME: newMessage
+ *
+ * DESCRIPTION: Build a message carrying count membership entries followed by trailerSize
+ * 				bytes of trailer. Size is messageSize(count) + trailerSize
+ */
+MessageHdr *MP1Node::newMessage(MsgTypes type, Address addr, const MemberListEntry *entries, long count,
+                                const void *trailer, size_t trailerSize) {
     MessageHdr *msg;
 
-    long memberListSize = memberList.size();
-    size_t msgsize =
-            sizeof(MessageHdr) + sizeof(addr.addr) + memberListSize * sizeof(MemberListEntry) + sizeof(long) + 1;
-    msg = (MessageHdr *) malloc(msgsize * sizeof(char));
+    msg = (MessageHdr *) malloc((messageSize(count) + trailerSize) * sizeof(char));
 
-    // create JOINREQ message: format of data is {struct Address myaddr}
     msg->msgType = type;
     memcpy((char *) (msg + 1), &(addr.addr), sizeof(addr.addr));
-    memcpy((char *) (msg + 1) + 1 + sizeof(addr.addr), &memberListSize, sizeof(long));
-    std::copy(reinterpret_cast<char *>(memberList.data()),
-              reinterpret_cast<char *>(memberList.data()) + memberListSize * sizeof(MemberListEntry),
-              (char *) (msg + 1) + 1 + sizeof(addr.addr) + sizeof(long));
+    memcpy((char *) (msg + 1) + 1 + sizeof(addr.addr), &count, sizeof(long));
+    memcpy((char *) (msg + 1) + 1 + sizeof(addr.addr) + sizeof(long), entries, count * sizeof(MemberListEntry));
+    memcpy((char *) msg + messageSize(count), trailer, trailerSize);
 
     return msg;
 }
 
+/**
+ * FUNCTION NAME: readEntries
+ *
+ * DESCRIPTION: Copy the membership entries of a message built by newMessage
+ *
+ * RETURNS:
+ * the trailer following the entries
+ */
+char *MP1Node::readEntries(MessageHdr *msg, vector <MemberListEntry> &entries) {
+    long count;
+    memcpy(&count, (char *) (msg + 1) + 1 + sizeof(Address), sizeof(long));
+    char *first = (char *) (msg + 1) + 1 + sizeof(Address) + sizeof(long);
+    entries.resize(count);
+    std::copy(first, first + count * sizeof(MemberListEntry), reinterpret_cast<char *>(entries.data()));
+    return (char *) msg + messageSize(count);
+}
+
+/**
+ * FUNCTION NAME: messageSize
+ *
+ * DESCRIPTION: Size of a message carrying count membership entries
+ */
+size_t MP1Node::messageSize(long count) {
+    return sizeof(MessageHdr) + sizeof(Address) + count * sizeof(MemberListEntry) + sizeof(long) + 1;
+}
+
+/**
+ * FUNCTION NAME: maxEntriesPerMessage
+ *
+ * DESCRIPTION: Number of membership entries that fit in one message accepted by EmulNet
+ */
+long MP1Node::maxEntriesPerMessage() {
+    long room = par->MAX_MSG_SIZE - (long) sizeof(en_msg) - (long) messageSize(0) - 1;
+    return room / (long) sizeof(MemberListEntry);
+}
+
 /**
  * FUNCTION NAME: recvCallBack
  *
@@ -253,34 +405,37 @@ bool MP1Node::recvCallBack(void *env, char *data, int size) {
             log->LOG(&self->addr, s);
 #endif
 
-            long *heartbeat = (long *) (msg + 1 + sizeof(addr->addr));
+            long heartbeat;
+            memcpy(&heartbeat, (char *) (msg + 1) + 1 + sizeof(addr->addr), sizeof(long));
 
             int id = *(int *) (&addr->addr);
             short port = *(short *) (&addr->addr[4]);
-            MemberListEntry mle(id, port, *heartbeat, this->par->getcurrtime());
-            printf("\nMember Added : %d:%d", mle.id, mle.port);
-            memberNode->memberList.push_back(mle);
-            log->logNodeAdd(&self->addr, addr);
-            MessageHdr *sendMsg = newMessage(JOINREP, self->addr, memberNode->memberList);
-            emulNet->ENsend(&memberNode->addr, addr, (char *) (sendMsg), sizeof(MessageHdr) + sizeof(Address) +
-                                                                         memberNode->memberList.size() *
-                                                                         sizeof(MemberListEntry) + 1);
-            free(sendMsg);
+            MemberListEntry mle(id, port, heartbeat, this->par->getcurrtime());
+            // A member that left may come back
+            departed.erase(memberKey(id, port));
+            // Answered from nodeLoopOps, at most JOINS_PER_TICK per round
+            pendingJoins.push_back(mle);
         }
             break;
 
         case JOINREP: {
             self->inGroup = true;
 
-            long membershipSize;
-            memcpy((char *) (&membershipSize), (char *) (msg + 1) + 1 + sizeof(addr->addr), sizeof(long));
             std::vector <MemberListEntry> membership;
-            membership.resize(membershipSize);
-
-            std::copy((char *) (msg + 1) + 1 + sizeof(long) + sizeof(addr->addr),
-                      (char *) (msg + 1) + 1 + sizeof(long) + sizeof(addr->addr) +
-                      membershipSize * sizeof(MemberListEntry), reinterpret_cast<char *>(membership.data()));
-            updateMembershipList(membership);
+            readEntries(msg, membership);
+            if (partialView()) {
+                // The introducer is our first neighbour; the ring digest follows
+                std::for_each(membership.begin(), membership.end(), [this](const MemberListEntry &mle) {
+                    addActivePeer(mle, true);
+                });
+            } else {
+                // Each chunk is a slice of the list on its own, merged as it comes; a lost
+                // one is made up for by gossip
+                updateMembershipList(membership);
+            }
+            if (joinedTime < 0) {
+                joinedTime = par->getcurrtime();
+            }
 #ifdef DEBUGLOG_1
             log->LOG(&self->addr, "Received JOINREP........................");
       printMembership(membership);
@@ -290,13 +445,8 @@ bool MP1Node::recvCallBack(void *env, char *data, int size) {
         }
             break;
         case HEARTBEAT: {
-            long membershipSize;
-            memcpy((char *) (&membershipSize), (char *) (msg + 1) + 1 + sizeof(addr->addr), sizeof(long));
             std::vector <MemberListEntry> membership;
-            membership.resize(membershipSize);
-            std::copy((char *) (msg + 1) + 1 + sizeof(long) + sizeof(addr->addr),
-                      (char *) (msg + 1) + 1 + sizeof(long) + sizeof(addr->addr) +
-                      membershipSize * sizeof(MemberListEntry), reinterpret_cast<char *>(membership.data()));
+            char *trailer = readEntries(msg, membership);
 #ifdef DEBUGLOG_1
             static char s[1024];
             sprintf(s, "Received Heartbeat from %d.%d.%d.%d:%d", addr->addr[0], addr->addr[1], addr->addr[2], addr->addr[3], addr->addr[4]);
@@ -307,6 +457,11 @@ bool MP1Node::recvCallBack(void *env, char *data, int size) {
 #endif
 
             updateMembershipList(membership);
+            if (partialView() && trailer < data + size) {
+                DigestSummary summary;
+                memcpy(&summary, trailer, sizeof(DigestSummary));
+                reconcileDigest(*addr, summary);
+            }
 
 #ifdef DEBUGLOG_1
             log->LOG(&self->addr, "After Membership Update......................");
@@ -314,10 +469,90 @@ bool MP1Node::recvCallBack(void *env, char *data, int size) {
 #endif
         }
             break;
+
+        case FORWARDJOIN: {
+            std::vector <MemberListEntry> joiner;
+            long ttl;
+            memcpy(&ttl, readEntries(msg, joiner), sizeof(long));
+            forwardJoin(*addr, joiner[0], ttl);
+        }
+            break;
+
+        case NEIGHBOR: {
+            std::vector <MemberListEntry> sender;
+            long priority;
+            memcpy(&priority, readEntries(msg, sender), sizeof(long));
+            if (!addActivePeer(sender[0], priority == HIGH_PRIORITY)) {
+                // Full: refuse, the sender tries another of its passive members
+                sendView(DISCONNECT, *addr, std::vector<MemberListEntry>(1, memberNode->memberList[0]), 0);
+            }
+        }
+            break;
+
+        case DISCONNECT: {
+            std::vector <MemberListEntry> sender;
+            readEntries(msg, sender);
+            unordered_map<long, MemberSlot>::iterator it = memberIndex.find(memberKey(sender[0].id, sender[0].port));
+            if (it != memberIndex.end() && it->second.pos != 0) {
+                removeMember(it->second.pos);
+                addPassivePeer(sender[0]);
+            }
+        }
+            break;
+
+        case SHUFFLE: {
+            std::vector <MemberListEntry> received;
+            readEntries(msg, received);
+            std::vector <MemberListEntry> reply;
+            sample(passiveView, 0, received.size(), reply);
+            sendView(SHUFFLEREP, *addr, reply, 0);
+            std::for_each(received.begin(), received.end(), [this](const MemberListEntry &mle) {
+                addPassivePeer(mle);
+            });
+        }
+            break;
+
+        case SHUFFLEREP: {
+            std::vector <MemberListEntry> received;
+            readEntries(msg, received);
+            std::for_each(received.begin(), received.end(), [this](const MemberListEntry &mle) {
+                addPassivePeer(mle);
+            });
+        }
+            break;
+
+        case RINGDIGEST: {
+            std::vector <MemberListEntry> none;
+            char *trailer = readEntries(msg, none);
+            long count;
+            memcpy(&count, trailer, sizeof(long));
+            for (long i = 0; i < count; i++) {
+                RingEntry entry;
+                memcpy(&entry, trailer + sizeof(long) + i * sizeof(RingEntry), sizeof(RingEntry));
+                applyDigest(entry);
+            }
+        }
+            break;
+
+        case LEAVE: {
+            std::vector <MemberListEntry> leaver;
+            readEntries(msg, leaver);
+            long key = memberKey(leaver[0].id, leaver[0].port);
+            departed[key] = par->getcurrtime() + TREMOVE;
+            unordered_map<long, MemberSlot>::iterator it = memberIndex.find(key);
+            if (it != memberIndex.end() && it->second.pos != 0) {
+                removeMember(it->second.pos, MEMBER_LEFT);
+            }
+        }
+            break;
+
+        default:
+            break;
     }
 
     free(msg);
     free(addr);
+    return true;
 }
 
 void MP1Node::printMembership(std::vector <MemberListEntry> memberList) {
@@ -348,81 +583,232 @@ void MP1Node::nodeLoopOps() {
     memberNode->memberList[0].timestamp = par->getcurrtime();
 
     removeMembersIfFailed();
-    sendHeartbeat();
+    answerJoinRequests();
+    if (partialView()) {
+        fillActiveView();
+        shuffleViews();
+        sendViewHeartbeat();
+    } else {
+        sendHeartbeat();
+    }
     return;
 }
 
+/**
+ * FUNCTION NAME: answerJoinRequests
+ *
+ * DESCRIPTION: Answer the JOINREQs queued since the last round, at most JOINS_PER_TICK of
+ * 				them. All the joiners of the batch are added to the group first, then one
+ * 				membership reply is built and sent to each of them, so they also learn
+ * 				about each other. The reply is at most JOINREP_MAX_CHUNKS JOINREP chunks;
+ * 				the live members go first, so a list too long for that is cut down to a
+ * 				bootstrap sample and the joiners catch up on the rest through gossip. The
+ * 				rest of the queue waits for the next round.
+ */
+void MP1Node::answerJoinRequests() {
+    if (pendingJoins.empty()) {
+        return;
+    }
+    size_t batch = std::min(pendingJoins.size(), (size_t) par->JOINS_PER_TICK);
+    if (partialView()) {
+        std::for_each(pendingJoins.begin(), pendingJoins.begin() + batch, [this](const MemberListEntry &mle) {
+            acceptJoin(mle);
+        });
+        joinsAnswered += batch;
+        pendingJoins.erase(pendingJoins.begin(), pendingJoins.begin() + batch);
+        return;
+    }
+    std::for_each(pendingJoins.begin(), pendingJoins.begin() + batch, [this](const MemberListEntry &mle) {
+        printf("\nMember Added : %d:%d", mle.id, mle.port);
+        mergeMember(mle);
+    });
+
+    long perChunk = maxEntriesPerMessage();
+    long count = std::min((long) memberNode->memberList.size(), perChunk * par->JOINREP_MAX_CHUNKS);
+    short total = (short) ((count + perChunk - 1) / perChunk);
+    std::vector <MessageHdr *> chunks;
+    std::vector <size_t> sizes;
+    for (short seq = 0; seq < total; seq++) {
+        long first = seq * perChunk;
+        long n = std::min(perChunk, count - first);
+        chunks.push_back(newMessage(JOINREP, memberNode->addr, memberNode->memberList.data() + first, n));
+        sizes.push_back(messageSize(n));
+    }
+
+    std::for_each(pendingJoins.begin(), pendingJoins.begin() + batch, [&](const MemberListEntry &mle) {
+        Address joiner = getAddress(mle.id, mle.port);
+        for (short seq = 0; seq < total; seq++) {
+            emulNet->ENsend(&memberNode->addr, &joiner, (char *) chunks[seq], sizes[seq]);
+            joinReplyMsgs++;
+            joinReplyBytes += sizes[seq];
+        }
+    });
+    joinsAnswered += batch;
+
+    std::for_each(chunks.begin(), chunks.end(), [](MessageHdr *msg) {
+        free(msg);
+    });
+    pendingJoins.erase(pendingJoins.begin(), pendingJoins.begin() + batch);
+}
+
+/**
+ * FUNCTION NAME: removeMembersIfFailed
+ *
+ * DESCRIPTION: Fire the failure timers that are due. A member not heard from within TFAIL
+ * 				(or, with PHI_ACCRUAL, whose suspicion level reached PHI_THRESHOLD) is moved
+ * 				out of the live part of the list and no longer gossiped; one still silent
+ * 				TREMOVE - TFAIL ticks later is deleted. Members heard from since their timer
+ * 				was armed are simply re-armed, so a tick only touches the timers that are due.
+ */
 void MP1Node::removeMembersIfFailed() {
 #ifdef DEBUGLOG_2
     log->LOG(&memberNode->addr, "MP1Node::removeMembersIfFailed");
 #endif
-    auto newEnd = std::remove_if(memberNode->memberList.begin(), memberNode->memberList.end(),
-                                 [this](MemberListEntry mle) {
-                                     if (mle.timestamp + TREMOVE <= par->getcurrtime()) {
-                                         Address addr = getAddress(mle.id, mle.port);
-                                         log->logNodeRemove(&memberNode->addr, &addr);
-                                         return true;
-                                     }
-                                 }
-    );
-    memberNode->memberList.erase(newEnd, memberNode->memberList.end());
+    long now = par->getcurrtime();
+    std::vector <Timer> due;
+    failureTimers.advance(now, due);
+
+    std::for_each(due.begin(), due.end(), [this, now](const Timer &timer) {
+        unordered_map<long, MemberSlot>::iterator it = memberIndex.find(timer.key);
+        if (it == memberIndex.end() || it->second.deadline != timer.deadline) {
+            // Member was removed or its timer re-armed since
+            return;
+        }
+        size_t pos = it->second.pos;
+        long timestamp = memberNode->memberList[pos].timestamp;
+        if (partialView()) {
+            // A silent neighbour is dropped at once and reported dead to the whole ring
+            if (failureDeadline(it->second, timestamp) <= now) {
+                MemberListEntry peer = memberNode->memberList[pos];
+                removeMember(pos);
+                announceMember(peer.id, peer.port, RING_FAILED);
+            } else {
+                armFailureTimer(timer.key, failureDeadline(it->second, timestamp));
+            }
+            return;
+        }
+        if (pos >= liveMembers) {
+            // Suspected members are re-armed as soon as they are heard from again
+            removeMember(pos);
+            return;
+        }
+        long deadline = failureDeadline(it->second, timestamp);
+        if (deadline <= now) {
+            swapMembers(pos, --liveMembers);
+            armFailureTimer(timer.key, now + TREMOVE - TFAIL);
+        } else {
+            armFailureTimer(timer.key, deadline);
+        }
+    });
 }
 
 
+/**
+ * FUNCTION NAME: sendHeartbeat
+ *
+ * DESCRIPTION: Gossip the live part of the membership list to the next gossipFanout()
+ * 				members of the round-robin permutation. With zones, a member of another
+ * 				zone is only gossiped to with probability CROSS_ZONE_GOSSIP when its turn
+ * 				comes, so gossip mostly stays within the zone. A member is gossiped to at
+ * 				most once a round
+ */
 void MP1Node::sendHeartbeat() {
 #ifdef DEBUGLOG_2
     log->LOG(&memberNode->addr, "MP1Node::sendHeartbeat");
-#endif
-    std::random_device rd;
-    std::mt19937 g(rd());
-#ifdef DEBUGLOG_2
     printMembership(memberNode->memberList);
 #endif
-    std::vector <MemberListEntry> v;
-    for (int i = 1; i < memberNode->memberList.size(); i++) {
-        if (memberNode->memberList[i].timestamp + TFAIL > par->getcurrtime())
-            v.push_back(memberNode->memberList[i]);
+    size_t fanout = gossipFanout();
+    std::vector <Address> targets;
+    // Members picked this round, as a reshuffle mid-round can bring them up again
+    unordered_set<long> picked;
+    bool reshuffled = false;
+    while (targets.size() < fanout) {
+        long key;
+        if (!gossip.next(key)) {
+            // One reshuffle per round at most, in case nobody is left to contact
+            if (reshuffled) {
+                break;
+            }
+            startGossipPass();
+            reshuffled = true;
+            continue;
+        }
+        unordered_map<long, MemberSlot>::iterator it = memberIndex.find(key);
+        if (it == memberIndex.end() || it->second.pos == 0 || it->second.pos >= liveMembers) {
+            // Removed, suspected or ourselves
+            continue;
+        }
+        MemberListEntry &mle = memberNode->memberList[it->second.pos];
+        if (par->zoneOf(mle.id) != par->zoneOf(getId(memberNode->addr)) &&
+            (double) (gossip.nextRandom() % 1000000) / 1000000 >= par->CROSS_ZONE_GOSSIP) {
+            continue;
+        }
+        if (!picked.insert(key).second) {
+            continue;
+        }
+        targets.push_back(getAddress(mle.id, mle.port));
     }
-#ifdef DEBUGLOG_2
-    log->LOG(&memberNode->addr, "MP1Node::sendHeartbeat::Failed Filtering");
-#endif
-    std::shuffle(v.begin(), v.end(), g);
 
-    v.push_back(memberNode->memberList[0]);
-#ifdef DEBUGLOG_2
-    printMembership(v);
-#endif
-
-    MessageHdr *msg = newMessage(HEARTBEAT, memberNode->addr, v);
-    Address *addr = (Address *) malloc(sizeof(Address));
-    int msgSize = sizeof(MessageHdr) + sizeof(Address) + v.size() * sizeof(MemberListEntry) + sizeof(long) + 1;
-    static char s[1024];
-
-#if 1
-    if (v.size() > 1) {
-        Address addr0 = getAddress(v[0].id, v[0].port);
-        memcpy((char *) addr, (char *) (&addr0), sizeof(Address));
-#ifdef DEBUGLOG_1
-        sprintf(s, "Sending heartbeat to %d.%d.%d.%d:%d", addr0.addr[0], addr0.addr[1], addr0.addr[2], addr0.addr[3], addr0.addr[4]);
-        log->LOG(&memberNode->addr, s);
-        printMembership(v);
-#endif
-        emulNet->ENsend(&memberNode->addr, addr, (char *) (msg), msgSize);
+    MessageHdr *msg;
+    int msgSize;
+    long maxEntries = maxEntriesPerMessage();
+    if ((long) liveMembers <= maxEntries) {
+        msg = newMessage(HEARTBEAT, memberNode->addr, memberNode->memberList.data(), liveMembers);
+        msgSize = messageSize(liveMembers);
+    } else {
+        // Too many to fit one message: ourselves plus the next window of the live members
+        std::vector <MemberListEntry> window(1, memberNode->memberList[0]);
+        for (long i = 0; i < maxEntries - 1; i++) {
+            gossipWindow = gossipWindow % (liveMembers - 1) + 1;
+            window.push_back(memberNode->memberList[gossipWindow]);
+        }
+        msg = newMessage(HEARTBEAT, memberNode->addr, window.data(), window.size());
+        msgSize = messageSize(window.size());
     }
-
-    if (v.size() > 2) {
-        Address addr1 = getAddress(v[1].id, v[1].port);
-        memcpy((char *) addr, (char *) (&addr1), sizeof(Address));
+    std::for_each(targets.begin(), targets.end(), [this, msg, msgSize](Address addr) {
+        if (heartbeatSuppressed(addr)) {
+            return;
+        }
 #ifdef DEBUGLOG_1
-        sprintf(s, "Sending heartbeat to %d.%d.%d.%d:%d", addr1.addr[0], addr1.addr[1], addr1.addr[2], addr1.addr[3], addr1.addr[4]);
+        static char s[1024];
+        sprintf(s, "Sending heartbeat to %d.%d.%d.%d:%d", addr.addr[0], addr.addr[1], addr.addr[2], addr.addr[3], addr.addr[4]);
         log->LOG(&memberNode->addr, s);
 #endif
-        emulNet->ENsend(&memberNode->addr, addr, (char *) (msg), msgSize);
-    }
-#endif
+        emulNet->ENsend(&memberNode->addr, &addr, (char *) (msg), msgSize);
+    });
 
     free(msg);
-    free(addr);
+}
+
+/**
+ * FUNCTION NAME: gossipFanout
+ *
+ * DESCRIPTION: Number of members gossiped to per round. GOSSIP_FANOUT when configured,
+ * 				otherwise ceil(log2(N)) with a floor of two
+ */
+size_t MP1Node::gossipFanout() {
+    if (par->GOSSIP_FANOUT > 0) {
+        return par->GOSSIP_FANOUT;
+    }
+    size_t fanout = 2;
+    while (((size_t) 1 << fanout) < liveMembers) {
+        fanout++;
+    }
+    return fanout;
+}
+
+/**
+ * FUNCTION NAME: startGossipPass
+ *
+ * DESCRIPTION: Reshuffle the live members into a new round-robin pass
+ */
+void MP1Node::startGossipPass() {
+    std::vector<long> keys;
+    keys.reserve(liveMembers);
+    for (size_t i = 1; i < liveMembers; i++) {
+        keys.push_back(memberKey(memberNode->memberList[i].id, memberNode->memberList[i].port));
+    }
+    gossip.reshuffle(keys);
 }
 
 
@@ -443,8 +829,29 @@ int MP1Node::isNullAddress(Address *addr) {
 Address MP1Node::getJoinAddress() {
     Address joinaddr;
 
+    // Seeds are the first JOIN_SEEDS nodes; only those started before us can answer.
+    // The first seed boots the group.
+    int id = getId(memberNode->addr);
+    int seeds = std::min(par->JOIN_SEEDS, id - 1);
+    int seed = 1;
+    if (seeds > 1) {
+        if (joinAttempts == 0) {
+            joinSeedOffset = par->SEED_SELECTION == RANDOM_SEED ? gossip.nextRandom() % seeds : id % seeds;
+        }
+        // Every retry moves on to the next seed
+        seed = 1 + (joinSeedOffset + joinAttempts) % seeds;
+    }
+
     memset(&joinaddr, 0, sizeof(Address));
-    *(int *) (&joinaddr.addr) = 1;
+    if (restarted) {
+        // The seeds may be down as well: a restarted node tries every other node in
+        // turn, and the first seed must not boot a group of its own
+        seed = 1 + joinAttempts % par->EN_GPSZ;
+        if (seed == id) {
+            seed = id % par->EN_GPSZ + 1;
+        }
+    }
+    *(int *) (&joinaddr.addr) = seed;
     *(short *) (&joinaddr.addr[4]) = 0;
 
     return joinaddr;
@@ -457,32 +864,722 @@ Address MP1Node::getJoinAddress() {
  */
 void MP1Node::initMemberListTable(Member *memberNode) {
     memberNode->memberList.clear();
+    memberIndex.clear();
+    failureTimers.clear();
 
     MemberListEntry myEntry(getId(memberNode->addr), getPort(memberNode->addr), memberNode->heartbeat,
                             this->par->getcurrtime());
     memberNode->memberList.push_back(myEntry);
     memberNode->myPos = memberNode->memberList.begin();
+
+    MemberSlot slot;
+    slot.pos = 0;
+    slot.deadline = -1;
+    slot.digestEpoch = -1;
+    slot.digestTime = -1;
+    slot.piggybackTime = -1;
+    memberIndex[memberKey(myEntry.id, myEntry.port)] = slot;
+    liveMembers = 1;
+    if (partialView()) {
+        passiveView.clear();
+        ringDigest.clear();
+        announceMember(myEntry.id, myEntry.port, RING_ALIVE);
+    } else {
+        publish(MEMBER_JOINED, memberNode->addr);
+    }
 }
 
-void MP1Node::updateMembershipList(std::vector <MemberListEntry> receivedMemberList) {
-    std::for_each(receivedMemberList.begin(), receivedMemberList.end(), [this](MemberListEntry mle) {
-        std::vector<MemberListEntry>::iterator it = std::find_if(memberNode->memberList.begin(),
-                                                                 memberNode->memberList.end(),
-                                                                 [mle](const MemberListEntry &m) {
-                                                                     return mle.id == m.id && mle.port == m.port;
-                                                                 });
-        if (it != memberNode->memberList.end()) {
-            if ((int) (mle.heartbeat) > (int) ((*it).heartbeat)) {
-                (*it).heartbeat = mle.heartbeat;
-                (*it).timestamp = par->getcurrtime();
+/**
+ * FUNCTION NAME: updateMembershipList
+ *
+ * DESCRIPTION: Merge a received membership list into ours, entry by entry
+ */
+void MP1Node::updateMembershipList(const std::vector <MemberListEntry> &receivedMemberList) {
+    std::for_each(receivedMemberList.begin(), receivedMemberList.end(), [this](const MemberListEntry &mle) {
+        mergeMember(mle);
+    });
+}
+
+/**
+ * FUNCTION NAME: mergeMember
+ *
+ * DESCRIPTION: Merge a received membership entry into ours. A known member whose heartbeat
+ * 				advanced is refreshed in place (its failure timer is re-armed lazily when
+ * 				it fires); a suspected one is brought back into the live part of the list.
+ * 				Members that left within TREMOVE are not added back.
+ */
+void MP1Node::mergeMember(MemberListEntry mle) {
+    unordered_map<long, MemberSlot>::iterator it = memberIndex.find(memberKey(mle.id, mle.port));
+    if (it != memberIndex.end()) {
+        MemberListEntry &known = memberNode->memberList[it->second.pos];
+        if ((int) (mle.heartbeat) > (int) (known.heartbeat)) {
+            long now = par->getcurrtime();
+            if (now > known.timestamp) {
+                it->second.arrivals.record(now - known.timestamp);
             }
-        } else {
-            mle.timestamp = par->getcurrtime();
-            memberNode->memberList.push_back(mle);
-            Address addr = getAddress(mle.id, mle.port);
-            log->logNodeAdd(&memberNode->addr, &addr);
+            known.heartbeat = mle.heartbeat;
+            known.timestamp = now;
+            if (it->second.pos >= liveMembers) {
+                armFailureTimer(it->first, failureDeadline(it->second, now));
+                swapMembers(it->second.pos, liveMembers++);
+            }
+        }
+    } else if (hasDeparted(memberKey(mle.id, mle.port))) {
+        // Stale entry of a member that left
+    } else if (partialView()) {
+        // Someone that takes us for a neighbour
+        if (!addActivePeer(mle, false)) {
+            sendView(DISCONNECT, getAddress(mle.id, mle.port),
+                     std::vector<MemberListEntry>(1, memberNode->memberList[0]), 0);
+        }
+    } else {
+        mle.timestamp = par->getcurrtime();
+        addMember(mle);
+    }
+}
+
+/**
+ * FUNCTION NAME: memberKey
+ *
+ * DESCRIPTION: Key identifying a member in the index and the timer wheel
+ */
+long MP1Node::memberKey(int id, short port) {
+    return ((long) id << 16) | (unsigned short) port;
+}
+
+/**
+ * FUNCTION NAME: addMember
+ *
+ * DESCRIPTION: Append a newly discovered member to the live part of the list
+ */
+void MP1Node::addMember(MemberListEntry mle) {
+    long key = memberKey(mle.id, mle.port);
+    MemberSlot slot;
+    slot.pos = memberNode->memberList.size();
+    slot.deadline = -1;
+    slot.digestEpoch = -1;
+    slot.digestTime = -1;
+    slot.piggybackTime = -1;
+    memberNode->memberList.push_back(mle);
+    memberIndex[key] = slot;
+    swapMembers(slot.pos, liveMembers++);
+    armFailureTimer(key, mle.timestamp + TFAIL);
+    gossip.add(key);
+
+    if (!partialView()) {
+        // With PARTIAL_VIEW the ring digest reports who joined
+        Address addr = getAddress(mle.id, mle.port);
+        log->logNodeAdd(&memberNode->addr, &addr);
+        publish(MEMBER_JOINED, addr);
+    }
+}
+
+/**
+ * FUNCTION NAME: swapMembers
+ *
+ * DESCRIPTION: Swap two entries of the membership list and fix up the index
+ */
+void MP1Node::swapMembers(size_t a, size_t b) {
+    if (a == b) {
+        return;
+    }
+    vector <MemberListEntry> &list = memberNode->memberList;
+    std::swap(list[a], list[b]);
+    memberIndex[memberKey(list[a].id, list[a].port)].pos = a;
+    memberIndex[memberKey(list[b].id, list[b].port)].pos = b;
+}
+
+/**
+ * FUNCTION NAME: removeMember
+ *
+ * DESCRIPTION: Delete the entry at pos by swapping it with the last one. type tells
+ * 				whether the member failed or left
+ */
+void MP1Node::removeMember(size_t pos, MembershipEventType type) {
+    vector <MemberListEntry> &list = memberNode->memberList;
+    if (pos < liveMembers) {
+        swapMembers(pos, --liveMembers);
+        pos = liveMembers;
+    }
+    Address addr = getAddress(list[pos].id, list[pos].port);
+
+    swapMembers(pos, list.size() - 1);
+    memberIndex.erase(memberKey(list.back().id, list.back().port));
+    list.pop_back();
+    if (!partialView()) {
+        // With PARTIAL_VIEW the ring digest reports who failed or left
+        log->logNodeRemove(&memberNode->addr, &addr);
+        publish(type, addr);
+    }
+}
+
+/**
+ * FUNCTION NAME: subscribe
+ *
+ * DESCRIPTION: Register a listener for the membership events of this node
+ */
+void MP1Node::subscribe(MembershipListener *listener) {
+    listeners.push_back(listener);
+}
+
+/**
+ * FUNCTION NAME: publish
+ *
+ * DESCRIPTION: Move the membership epoch forward and hand the change to every listener
+ */
+void MP1Node::publish(MembershipEventType type, Address addr) {
+    MembershipEvent event;
+    event.type = type;
+    event.addr = addr;
+    event.epoch = ++membershipEpoch;
+    std::for_each(listeners.begin(), listeners.end(), [&event](MembershipListener *listener) {
+        listener->membershipChanged(event);
+    });
+}
+
+/**
+ * FUNCTION NAME: getMembershipEpoch
+ *
+ * DESCRIPTION: Returns the epoch of the last membership change
+ */
+long MP1Node::getMembershipEpoch() {
+    return membershipEpoch;
+}
+
+/**
+ * FUNCTION NAME: knownMembers
+ *
+ * DESCRIPTION: Returns the number of members this node knows to be in the group
+ */
+size_t MP1Node::knownMembers() {
+    return partialView() ? ringDigest.alive() : memberNode->memberList.size();
+}
+
+/**
+ * FUNCTION NAME: armFailureTimer
+ *
+ * DESCRIPTION: Schedule the next failure check of a member. Timers armed earlier for
+ * 				the same member become stale and are dropped when they fire.
+ */
+void MP1Node::armFailureTimer(long key, long deadline) {
+    memberIndex[key].deadline = deadline;
+    failureTimers.schedule(key, deadline);
+}
+
+/**
+ * FUNCTION NAME: failureDeadline
+ *
+ * DESCRIPTION: Returns the tick at which a member last heard from at timestamp is to be
+ * 				suspected: TFAIL ticks later, or with PHI_ACCRUAL the tick its suspicion
+ * 				level crosses PHI_THRESHOLD. Members without recorded arrivals yet fall
+ * 				back to TFAIL.
+ */
+long MP1Node::failureDeadline(const MemberSlot &slot, long timestamp) {
+    const ArrivalWindow &arrivals = slot.arrivals;
+    if (par->FAILURE_DETECTOR != PHI_ACCRUAL || arrivals.empty()) {
+        return timestamp + TFAIL;
+    }
+    return timestamp + arrivals.crossing(par->PHI_THRESHOLD);
+}
+
+/**
+ * FUNCTION NAME: partialView
+ *
+ * DESCRIPTION: Whether this node runs the PARTIAL_VIEW membership protocol
+ */
+bool MP1Node::partialView() {
+    return par->MEMBERSHIP_MODE == PARTIAL_VIEW;
+}
+
+/**
+ * FUNCTION NAME: activeViewSize
+ *
+ * DESCRIPTION: Number of neighbours in the active view. ACTIVE_VIEW_SIZE when configured,
+ * 				otherwise ceil(log2(N)) + 1
+ */
+size_t MP1Node::activeViewSize() {
+    if (par->ACTIVE_VIEW_SIZE > 0) {
+        return par->ACTIVE_VIEW_SIZE;
+    }
+    size_t size = 1;
+    while (((size_t) 1 << size) < (size_t) par->EN_GPSZ) {
+        size++;
+    }
+    return size + 1;
+}
+
+/**
+ * FUNCTION NAME: passiveViewSize
+ *
+ * DESCRIPTION: Number of members in the passive view. PASSIVE_VIEW_SIZE when configured,
+ * 				otherwise six times the active view
+ */
+size_t MP1Node::passiveViewSize() {
+    if (par->PASSIVE_VIEW_SIZE > 0) {
+        return par->PASSIVE_VIEW_SIZE;
+    }
+    return 6 * activeViewSize();
+}
+
+/**
+ * FUNCTION NAME: addActivePeer
+ *
+ * DESCRIPTION: Make a member a neighbour. When the active view is full a forced add
+ * 				disconnects a random neighbour, which goes to the passive view
+ *
+ * RETURNS:
+ * false if the view was full and the member was not added
+ */
+bool MP1Node::addActivePeer(MemberListEntry mle, bool force) {
+    long key = memberKey(mle.id, mle.port);
+    if (memberIndex.count(key)) {
+        return true;
+    }
+    std::vector <MemberListEntry> &list = memberNode->memberList;
+    if (list.size() - 1 >= activeViewSize()) {
+        if (!force) {
+            return false;
         }
+        size_t victim = 1 + gossip.nextRandom() % (list.size() - 1);
+        MemberListEntry evicted = list[victim];
+        sendView(DISCONNECT, getAddress(evicted.id, evicted.port), std::vector<MemberListEntry>(1, list[0]), 0);
+        removeMember(victim);
+        addPassivePeer(evicted);
+    }
+    removePassivePeer(key);
+    mle.timestamp = par->getcurrtime();
+    addMember(mle);
+    return true;
+}
+
+/**
+ * FUNCTION NAME: addPassivePeer
+ *
+ * DESCRIPTION: Keep a member as a backup neighbour, replacing a random one when the
+ * 				passive view is full. Ourselves, neighbours and dead members are skipped
+ */
+void MP1Node::addPassivePeer(const MemberListEntry &mle) {
+    long key = memberKey(mle.id, mle.port);
+    if (memberIndex.count(key)) {
+        return;
+    }
+    const RingEntry *entry = ringDigest.find(mle.id, mle.port);
+    if (entry && entry->state != RING_ALIVE) {
+        return;
+    }
+    bool known = std::any_of(passiveView.begin(), passiveView.end(), [this, key](const MemberListEntry &passive) {
+        return memberKey(passive.id, passive.port) == key;
     });
+    if (known) {
+        return;
+    }
+    if (passiveView.size() < passiveViewSize()) {
+        passiveView.push_back(mle);
+    } else {
+        passiveView[gossip.nextRandom() % passiveView.size()] = mle;
+    }
+}
+
+/**
+ * FUNCTION NAME: removePassivePeer
+ *
+ * DESCRIPTION: Take a member out of the passive view
+ */
+void MP1Node::removePassivePeer(long key) {
+    for (size_t i = 0; i < passiveView.size(); i++) {
+        if (memberKey(passiveView[i].id, passiveView[i].port) == key) {
+            passiveView[i] = passiveView.back();
+            passiveView.pop_back();
+            return;
+        }
+    }
+}
+
+/**
+ * FUNCTION NAME: sample
+ *
+ * DESCRIPTION: Append up to count distinct random entries of from[first, end) to out
+ */
+void MP1Node::sample(const vector <MemberListEntry> &from, size_t first, size_t count,
+                     vector <MemberListEntry> &out) {
+    std::vector <size_t> picks;
+    for (size_t i = first; i < from.size(); i++) {
+        picks.push_back(i);
+    }
+    for (size_t i = 0; i < picks.size() && i < count; i++) {
+        std::swap(picks[i], picks[i + gossip.nextRandom() % (picks.size() - i)]);
+        out.push_back(from[picks[i]]);
+    }
+}
+
+/**
+ * FUNCTION NAME: acceptJoin
+ *
+ * DESCRIPTION: PARTIAL_VIEW introducer side of a join. The joiner is added to the ring,
+ * 				made a neighbour and spread through the group by a FORWARDJOIN random
+ * 				walk from each of our other neighbours. It gets a JOINREP naming us and
+ * 				the whole ring digest.
+ */
+void MP1Node::acceptJoin(const MemberListEntry &joiner) {
+    printf("\nMember Added : %d:%d", joiner.id, joiner.port);
+    announceMember(joiner.id, joiner.port, RING_ALIVE);
+
+    std::vector <MemberListEntry> &list = memberNode->memberList;
+    std::vector <MemberListEntry> entries(1, joiner);
+    for (size_t i = 1; i < list.size(); i++) {
+        sendView(FORWARDJOIN, getAddress(list[i].id, list[i].port), entries, ARWL);
+    }
+    addActivePeer(joiner, true);
+
+    Address addr = getAddress(joiner.id, joiner.port);
+    MessageHdr *msg = newMessage(JOINREP, memberNode->addr, list.data(), 1);
+    emulNet->ENsend(&memberNode->addr, &addr, (char *) msg, messageSize(1));
+    joinReplyMsgs++;
+    joinReplyBytes += messageSize(1);
+    free(msg);
+    pushDigest(addr, -1);
+}
+
+/**
+ * FUNCTION NAME: forwardJoin
+ *
+ * DESCRIPTION: One hop of the FORWARDJOIN random walk. The walk ends, and the joiner
+ * 				becomes our neighbour, once ttl runs out or we have no one to pass it to;
+ * 				at hop PRWL the joiner is also kept in the passive view
+ */
+void MP1Node::forwardJoin(Address sender, const MemberListEntry &joiner, long ttl) {
+    std::vector <MemberListEntry> &list = memberNode->memberList;
+    long senderKey = memberKey(getId(sender), getPort(sender));
+    long joinerKey = memberKey(joiner.id, joiner.port);
+    if (joinerKey == memberKey(list[0].id, list[0].port)) {
+        return;
+    }
+    std::vector <MemberListEntry> next;
+    if (ttl > 0) {
+        std::vector <MemberListEntry> candidates;
+        std::copy_if(list.begin() + 1, list.end(), std::back_inserter(candidates),
+                     [this, senderKey, joinerKey](const MemberListEntry &mle) {
+                         long key = memberKey(mle.id, mle.port);
+                         return key != senderKey && key != joinerKey;
+                     });
+        sample(candidates, 0, 1, next);
+    }
+    if (next.empty()) {
+        if (addActivePeer(joiner, true)) {
+            sendView(NEIGHBOR, getAddress(joiner.id, joiner.port), std::vector<MemberListEntry>(1, list[0]),
+                     HIGH_PRIORITY);
+        }
+        return;
+    }
+    if (ttl == PRWL) {
+        addPassivePeer(joiner);
+    }
+    sendView(FORWARDJOIN, getAddress(next[0].id, next[0].port), std::vector<MemberListEntry>(1, joiner), ttl - 1);
+}
+
+/**
+ * FUNCTION NAME: fillActiveView
+ *
+ * DESCRIPTION: Replace a lost neighbour by a random passive member, one per round. The
+ * 				request is high priority when we have no neighbour left. An empty passive
+ * 				view is refilled from the ring digest.
+ */
+void MP1Node::fillActiveView() {
+    std::vector <MemberListEntry> &list = memberNode->memberList;
+    if (list.size() - 1 >= activeViewSize()) {
+        return;
+    }
+    if (passiveView.empty() && ringDigest.size() > 0) {
+        for (size_t i = 0; i < passiveViewSize(); i++) {
+            const RingEntry &entry = ringDigest.at(gossip.nextRandom() % ringDigest.size());
+            if (entry.state == RING_ALIVE) {
+                addPassivePeer(MemberListEntry(entry.id, entry.port, 0, par->getcurrtime()));
+            }
+        }
+    }
+    if (passiveView.empty()) {
+        return;
+    }
+    size_t pick = gossip.nextRandom() % passiveView.size();
+    MemberListEntry candidate = passiveView[pick];
+    long priority = list.size() == 1 ? HIGH_PRIORITY : LOW_PRIORITY;
+    if (addActivePeer(candidate, false)) {
+        sendView(NEIGHBOR, getAddress(candidate.id, candidate.port), std::vector<MemberListEntry>(1, list[0]),
+                 priority);
+    }
+}
+
+/**
+ * FUNCTION NAME: shuffleViews
+ *
+ * DESCRIPTION: Every SHUFFLE_PERIOD rounds, swap a sample of our views with a random
+ * 				neighbour, which answers with as many of its passive members
+ */
+void MP1Node::shuffleViews() {
+    std::vector <MemberListEntry> &list = memberNode->memberList;
+    if (list.size() < 2 || par->SHUFFLE_PERIOD <= 0 ||
+        (par->getcurrtime() + getId(memberNode->addr)) % par->SHUFFLE_PERIOD != 0) {
+        return;
+    }
+    std::vector <MemberListEntry> target;
+    sample(list, 1, 1, target);
+    long targetKey = memberKey(target[0].id, target[0].port);
+
+    std::vector <MemberListEntry> others;
+    std::copy_if(list.begin() + 1, list.end(), std::back_inserter(others), [this, targetKey](const MemberListEntry &mle) {
+        return memberKey(mle.id, mle.port) != targetKey;
+    });
+    std::vector <MemberListEntry> entries(1, list[0]);
+    sample(others, 0, SHUFFLE_ACTIVE, entries);
+    sample(passiveView, 0, SHUFFLE_PASSIVE, entries);
+    sendView(SHUFFLE, getAddress(target[0].id, target[0].port), entries, 0);
+}
+
+/**
+ * FUNCTION NAME: sendViewHeartbeat
+ *
+ * DESCRIPTION: PARTIAL_VIEW heartbeat: our own entry and the summary of our ring digest,
+ * 				sent to every neighbour
+ */
+void MP1Node::sendViewHeartbeat() {
+    std::vector <MemberListEntry> &list = memberNode->memberList;
+    DigestSummary summary = ringDigest.summary();
+    MessageHdr *msg = newMessage(HEARTBEAT, memberNode->addr, list.data(), 1, &summary, sizeof(DigestSummary));
+    size_t msgSize = messageSize(1) + sizeof(DigestSummary);
+    for (size_t i = 1; i < list.size(); i++) {
+        Address addr = getAddress(list[i].id, list[i].port);
+        if (!heartbeatSuppressed(addr)) {
+            emulNet->ENsend(&memberNode->addr, &addr, (char *) msg, msgSize);
+        }
+    }
+    free(msg);
+}
+
+/**
+ * FUNCTION NAME: sendView
+ *
+ * DESCRIPTION: Send a PARTIAL_VIEW control message: membership entries followed by a
+ * 				long argument (walk ttl, NEIGHBOR priority)
+ */
+void MP1Node::sendView(MsgTypes type, Address to, const vector <MemberListEntry> &entries, long arg) {
+    MessageHdr *msg = newMessage(type, memberNode->addr, entries.data(), entries.size(), &arg, sizeof(long));
+    emulNet->ENsend(&memberNode->addr, &to, (char *) msg, messageSize(entries.size()) + sizeof(long));
+    free(msg);
+}
+
+/**
+ * FUNCTION NAME: announceMember
+ *
+ * DESCRIPTION: Decide locally that a member joined, failed or left. The change is
+ * 				published here and reaches the other nodes by digest reconciliation
+ */
+void MP1Node::announceMember(int id, short port, RingState state) {
+    const RingEntry *known = ringDigest.find(id, port);
+    bool wasAlive = known && known->state == RING_ALIVE;
+    ringDigest.announce(id, port, state);
+    if (wasAlive == (state == RING_ALIVE)) {
+        return;
+    }
+    Address addr = getAddress(id, port);
+    if (state == RING_ALIVE) {
+        log->logNodeAdd(&memberNode->addr, &addr);
+        publish(MEMBER_JOINED, addr);
+    } else {
+        log->logNodeRemove(&memberNode->addr, &addr);
+        publish(state == RING_LEFT ? MEMBER_LEFT : MEMBER_FAILED, addr);
+        removePassivePeer(memberKey(id, port));
+    }
+}
+
+/**
+ * FUNCTION NAME: applyDigest
+ *
+ * DESCRIPTION: Merge a ring digest entry received from a neighbour and publish what it
+ * 				changes. Being reported dead ourselves is refuted with a newer entry. A
+ * 				neighbour that left is dropped from the views right away.
+ */
+void MP1Node::applyDigest(const RingEntry &entry) {
+    RingEntry previous;
+    if (!ringDigest.merge(entry, previous)) {
+        return;
+    }
+    if (entry.id == getId(memberNode->addr) && entry.port == getPort(memberNode->addr)) {
+        if (entry.state != RING_ALIVE) {
+            ringDigest.announce(entry.id, entry.port, RING_ALIVE);
+        }
+        return;
+    }
+    Address addr = getAddress(entry.id, entry.port);
+    long key = memberKey(entry.id, entry.port);
+    if (entry.state == RING_ALIVE && previous.state != RING_ALIVE) {
+        log->logNodeAdd(&memberNode->addr, &addr);
+        publish(MEMBER_JOINED, addr);
+    } else if (entry.state != RING_ALIVE && previous.state == RING_ALIVE) {
+        log->logNodeRemove(&memberNode->addr, &addr);
+        publish(entry.state == RING_LEFT ? MEMBER_LEFT : MEMBER_FAILED, addr);
+        removePassivePeer(key);
+    }
+    if (entry.state == RING_LEFT) {
+        departed[key] = par->getcurrtime() + TREMOVE;
+        unordered_map<long, MemberSlot>::iterator it = memberIndex.find(key);
+        if (it != memberIndex.end() && it->second.pos != 0) {
+            removeMember(it->second.pos);
+        }
+    }
+}
+
+/**
+ * FUNCTION NAME: reconcileDigest
+ *
+ * DESCRIPTION: Compare the digest summary of a neighbour with ours. The side with the
+ * 				newer epoch pushes the entries the other has not seen; with equal epochs
+ * 				but different entries, both push everything. A push is not repeated
+ * 				within DIGEST_RESEND rounds unless there is something new to send.
+ */
+void MP1Node::reconcileDigest(Address peer, const DigestSummary &theirs) {
+    DigestSummary mine = ringDigest.summary();
+    if (theirs.checksum == mine.checksum || theirs.epoch > mine.epoch) {
+        return;
+    }
+    unordered_map<long, MemberSlot>::iterator it = memberIndex.find(memberKey(getId(peer), getPort(peer)));
+    if (it == memberIndex.end()) {
+        return;
+    }
+    MemberSlot &slot = it->second;
+    long now = par->getcurrtime();
+    bool recent = now - slot.digestTime < DIGEST_RESEND;
+    long from;
+    if (theirs.epoch < mine.epoch) {
+        from = recent ? std::max(theirs.epoch, slot.digestEpoch) : theirs.epoch;
+        if (from >= mine.epoch) {
+            return;
+        }
+    } else {
+        if (recent) {
+            return;
+        }
+        from = -1;
+    }
+    pushDigest(peer, from);
+    slot.digestEpoch = mine.epoch;
+    slot.digestTime = now;
+}
+
+/**
+ * FUNCTION NAME: pushDigest
+ *
+ * DESCRIPTION: Send the ring digest entries decided after epoch from, as many RINGDIGEST
+ * 				messages as needed. Format is {MessageHdr, Address, pad, long 0, long count,
+ * 				RingEntry entries}
+ */
+void MP1Node::pushDigest(Address to, long from) {
+    std::vector <RingEntry> entries;
+    ringDigest.since(from, entries);
+    long perMessage = (par->MAX_MSG_SIZE - (long) sizeof(en_msg) - (long) messageSize(0) - (long) sizeof(long) - 1) /
+                      (long) sizeof(RingEntry);
+    for (long first = 0; first < (long) entries.size(); first += perMessage) {
+        long count = std::min(perMessage, (long) entries.size() - first);
+        std::vector<char> trailer(sizeof(long) + count * sizeof(RingEntry));
+        memcpy(trailer.data(), &count, sizeof(long));
+        memcpy(trailer.data() + sizeof(long), entries.data() + first, count * sizeof(RingEntry));
+        MessageHdr *msg = newMessage(RINGDIGEST, memberNode->addr, NULL, 0, trailer.data(), trailer.size());
+        emulNet->ENsend(&memberNode->addr, &to, (char *) msg, messageSize(0) + trailer.size());
+        free(msg);
+    }
+}
+
+/**
+ * FUNCTION NAME: outgoing
+ *
+ * DESCRIPTION: Append the membership delta riding on a key-value message to a member to
+ * 				out: our own entry followed by the next PIGGYBACK_ENTRIES - 1 live members,
+ * 				round-robin. With PARTIAL_VIEW only our entry is sent, the ring travels in
+ * 				the digest. Each entry is PIGGYBACK_ENTRY_SIZE bytes, written straight from
+ * 				the membership list
+ */
+void MP1Node::outgoing(Address *to, string &out) {
+    if (!memberNode->inGroup || memberNode->bFailed || par->PIGGYBACK_ENTRIES <= 0) {
+        return;
+    }
+    std::vector <MemberListEntry> &list = memberNode->memberList;
+    auto append = [this, &out](const MemberListEntry &mle) {
+        Address addr = getAddress(mle.id, mle.port);
+        int64_t heartbeat = mle.heartbeat;
+        out.append(addr.addr, sizeof(addr.addr));
+        out.append((const char *) &heartbeat, sizeof(heartbeat));
+    };
+    append(list[0]);
+    if (!partialView()) {
+        for (long i = 1; i < par->PIGGYBACK_ENTRIES && i < (long) liveMembers; i++) {
+            piggybackWindow = piggybackWindow % (liveMembers - 1) + 1;
+            append(list[piggybackWindow]);
+        }
+    }
+
+    unordered_map<long, MemberSlot>::iterator it = memberIndex.find(memberKey(getId(*to), getPort(*to)));
+    if (it != memberIndex.end()) {
+        it->second.piggybackTime = par->getcurrtime();
+    }
+    piggybacksSent++;
+}
+
+/**
+ * FUNCTION NAME: incoming
+ *
+ * DESCRIPTION: Merge the membership delta of a received key-value message, reading its
+ * 				entries in place off the message. Its first entry is the sender's, so the
+ * 				message counts as a heartbeat from it. With PARTIAL_VIEW only neighbours
+ * 				are refreshed.
+ */
+void MP1Node::incoming(string_view delta) {
+    if (!memberNode->inGroup || memberNode->bFailed) {
+        return;
+    }
+    for (size_t at = 0; at + PIGGYBACK_ENTRY_SIZE <= delta.size(); at += PIGGYBACK_ENTRY_SIZE) {
+        Address addr;
+        int64_t heartbeat;
+        memcpy(addr.addr, delta.data() + at, sizeof(addr.addr));
+        memcpy(&heartbeat, delta.data() + at + sizeof(addr.addr), sizeof(heartbeat));
+        MemberListEntry mle(getId(addr), getPort(addr), (long) heartbeat, par->getcurrtime());
+        if (partialView() && !memberIndex.count(memberKey(mle.id, mle.port))) {
+            continue;
+        }
+        mergeMember(mle);
+    }
+}
+
+/**
+ * FUNCTION NAME: heartbeatSuppressed
+ *
+ * DESCRIPTION: Whether a heartbeat to a member can be skipped because our entry rode on
+ * 				a key-value message to it within the last HEARTBEAT_SUPPRESS rounds
+ */
+bool MP1Node::heartbeatSuppressed(const Address &to) {
+    unordered_map<long, MemberSlot>::iterator it = memberIndex.find(memberKey(getId(to), getPort(to)));
+    if (it == memberIndex.end() || it->second.piggybackTime < 0 ||
+        par->getcurrtime() - it->second.piggybackTime >= par->HEARTBEAT_SUPPRESS) {
+        return false;
+    }
+    heartbeatsSuppressed++;
+    return true;
+}
+
+/**
+ * FUNCTION NAME: hasDeparted
+ *
+ * DESCRIPTION: Whether a member left less than TREMOVE rounds ago, so that entries of it
+ * 				still gossiped by others are ignored
+ */
+bool MP1Node::hasDeparted(long key) {
+    unordered_map<long, long>::iterator it = departed.find(key);
+    if (it == departed.end()) {
+        return false;
+    }
+    if (it->second <= par->getcurrtime()) {
+        departed.erase(it);
+        return false;
+    }
+    return true;
 }
 
 /**
@@ -14,12 +14,27 @@
 #include "Member.h"
 #include "EmulNet.h"
 #include "Queue.h"
+#include "TimerWheel.h"
+#include "GossipSelector.h"
+#include "ArrivalWindow.h"
+#include "RingDigest.h"
+#include "MembershipEvent.h"
+#include "MembershipPiggyback.h"
 
 /**
  * Macros
  */
 #define TREMOVE 20
 #define TFAIL 10
+// PARTIAL_VIEW: length of the FORWARDJOIN random walk, and the hop at which the
+// joiner is put in the passive view
+#define ARWL 6
+#define PRWL 3
+// PARTIAL_VIEW: active and passive members sent in a SHUFFLE besides ourselves
+#define SHUFFLE_ACTIVE 3
+#define SHUFFLE_PASSIVE 4
+// PARTIAL_VIEW: rounds before a ring digest push is repeated to a neighbour
+#define DIGEST_RESEND 4
 
 /*
  * Note: You can change/add any functions in MP1Node.{h,cpp}
@@ -32,9 +47,24 @@ enum MsgTypes {
     JOINREQ,
     JOINREP,
     HEARTBEAT,
+    FORWARDJOIN,
+    NEIGHBOR,
+    DISCONNECT,
+    SHUFFLE,
+    SHUFFLEREP,
+    RINGDIGEST,
+    LEAVE,
     DUMMYLASTMSGTYPE
 };
 
+/**
+ * Priority of a NEIGHBOR request. A high priority one is never refused
+ */
+enum NeighborPriority {
+    LOW_PRIORITY,
+    HIGH_PRIORITY
+};
+
 /**
  * STRUCT NAME: MessageHdr
  *
@@ -44,18 +74,148 @@ typedef struct MessageHdr {
     enum MsgTypes msgType;
 } MessageHdr;
 
+/**
+ * STRUCT NAME: MemberSlot
+ *
+ * DESCRIPTION: Where a member lives in the membership list, the deadline of the
+ * 				failure timer currently armed for it and its heartbeat arrivals.
+ * 				With PARTIAL_VIEW, also the last ring digest push to the member.
+ * 				piggybackTime is when our entry last rode on a key-value message to it.
+ */
+typedef struct MemberSlot {
+    size_t pos;
+    long deadline;
+    ArrivalWindow arrivals;
+    long digestEpoch;
+    long digestTime;
+    long piggybackTime;
+} MemberSlot;
+
 /**
  * CLASS NAME: MP1Node
  *
  * DESCRIPTION: Class implementing Membership protocol functionalities for failure detection
+ *
+ * 				With PARTIAL_VIEW the membership list only holds this node and its active
+ * 				view, the few neighbours it heartbeats with, and a passive view of backup
+ * 				neighbours is kept aside (HyParView). Both are O(log N). Who is in the ring
+ * 				is then learnt from the RingDigest, which neighbours reconcile through
+ * 				the summary carried by their heartbeats; the membership events come from
+ * 				the digest rather than the views.
+ *
+ * 				Key-value messages carry our entry and a few others (MembershipPiggyback);
+ * 				a member that just got one is not sent a heartbeat as well.
+ *
+ * 				A node leaving gracefully tells the group at once (LEAVE, or a RING_LEFT
+ * 				digest entry with PARTIAL_VIEW) instead of waiting to be found failed.
  */
-class MP1Node {
+class MP1Node : public MembershipPiggyback {
 private:
     EmulNet *emulNet;
     Log *log;
     Params *par;
     Member *memberNode;
     char NULLADDR[6];
+    // Position and armed deadline of every member, keyed by memberKey
+    unordered_map<long, MemberSlot> memberIndex;
+    // Failure and removal deadlines of the members
+    TimerWheel failureTimers;
+    // memberList[0, liveMembers) have been heard from within TFAIL, the rest are suspected
+    size_t liveMembers;
+    // Round-robin gossip targets and this node's PRNG
+    GossipSelector gossip;
+    // Number of membership changes published so far
+    long membershipEpoch;
+    // Subscribers of the membership events
+    vector<MembershipListener *> listeners;
+    // JOINREQs waiting for a JOINREP
+    vector <MemberListEntry> pendingJoins;
+    // Last live member put in a heartbeat too large to carry the whole list
+    long gossipWindow;
+    // JOINREQs sent to seeds and the seed picked for the first one
+    int joinAttempts;
+    int joinSeedOffset;
+    long joinRequestTime;
+    // When this node started joining and got its first JOINREP
+    long joinStartTime;
+    long joinedTime;
+    // Load taken as an introducer
+    long joinsAnswered;
+    long joinReplyMsgs;
+    long joinReplyBytes;
+    // PARTIAL_VIEW: backup neighbours
+    vector <MemberListEntry> passiveView;
+    // PARTIAL_VIEW: members of the ring
+    RingDigest ringDigest;
+    // Last live member put in a piggybacked delta
+    long piggybackWindow;
+    // Key-value messages we rode on, and heartbeats they made unnecessary
+    long piggybacksSent;
+    long heartbeatsSuppressed;
+    // Members that left, keyed by memberKey, and until when their stale entries are ignored
+    unordered_map<long, long> departed;
+    // Whether this node has been restarted after going down
+    bool restarted;
+
+    long memberKey(int id, short port);
+
+    void addMember(MemberListEntry mle);
+
+    void swapMembers(size_t a, size_t b);
+
+    void removeMember(size_t pos, MembershipEventType type = MEMBER_FAILED);
+
+    void armFailureTimer(long key, long deadline);
+
+    long failureDeadline(const MemberSlot &slot, long timestamp);
+
+    size_t gossipFanout();
+
+    void startGossipPass();
+
+    void publish(MembershipEventType type, Address addr);
+
+    void answerJoinRequests();
+
+    long maxEntriesPerMessage();
+
+    bool partialView();
+
+    size_t activeViewSize();
+
+    size_t passiveViewSize();
+
+    bool addActivePeer(MemberListEntry mle, bool force);
+
+    void addPassivePeer(const MemberListEntry &mle);
+
+    void removePassivePeer(long key);
+
+    void sample(const vector <MemberListEntry> &from, size_t first, size_t count, vector <MemberListEntry> &out);
+
+    void acceptJoin(const MemberListEntry &joiner);
+
+    void forwardJoin(Address sender, const MemberListEntry &joiner, long ttl);
+
+    void fillActiveView();
+
+    void shuffleViews();
+
+    void sendViewHeartbeat();
+
+    void sendView(MsgTypes type, Address to, const vector <MemberListEntry> &entries, long arg);
+
+    void announceMember(int id, short port, RingState state);
+
+    void applyDigest(const RingEntry &entry);
+
+    void reconcileDigest(Address peer, const DigestSummary &theirs);
+
+    void pushDigest(Address to, long from);
+
+    bool heartbeatSuppressed(const Address &to);
+
+    bool hasDeparted(long key);
 
 public:
     MP1Node(Member *, Params *, EmulNet *, Log *, Address *);
@@ -76,6 +236,10 @@ public:
 
     int finishUpThisNode();
 
+    void leaveGroup();
+
+    void rejoinGroup();
+
     void nodeLoop();
 
     void checkMessages();
@@ -92,9 +256,18 @@ public:
 
     void printAddress(Address *addr);
 
-    MessageHdr *newMessage(MsgTypes type, Address addr, vector <MemberListEntry> memberList);
+    MessageHdr *newMessage(MsgTypes type, Address addr, const MemberListEntry *entries, long count);
+
+    MessageHdr *newMessage(MsgTypes type, Address addr, const MemberListEntry *entries, long count,
+                           const void *trailer, size_t trailerSize);
+
+    char *readEntries(MessageHdr *msg, vector <MemberListEntry> &entries);
+
+    size_t messageSize(long count);
 
-    void updateMembershipList(std::vector <MemberListEntry>);
+    void updateMembershipList(const std::vector <MemberListEntry> &);
+
+    void mergeMember(MemberListEntry mle);
 
     void removeMembersIfFailed();
 
@@ -108,6 +281,16 @@ public:
 
     short getPort(Address addr);
 
+    void subscribe(MembershipListener *listener);
+
+    long getMembershipEpoch();
+
+    size_t knownMembers();
+
+    void outgoing(Address *to, string &out);
+
+    void incoming(string_view delta);
+
     virtual ~MP1Node();
 };
 
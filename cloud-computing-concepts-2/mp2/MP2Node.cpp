@@ -14,8 +14,25 @@ MP2Node::MP2Node(Member *memberNode, Params *par, EmulNet *emulNet, Log *log, Ad
     this->emulNet = emulNet;
     this->log = log;
     ht = new HashTable();
-    transactions = map<int, Transaction>();
     this->memberNode->addr = *address;
+    this->ringEpoch = 0;
+    this->ringMembers = 0;
+    this->ringChecksum = 0;
+    this->piggyback = NULL;
+    this->catchUpPending = true;
+    this->catchUpSince = -1;
+    this->requestsServed = 0;
+    this->placementCost = PlacementCost();
+    this->nextTransferId = 0;
+    this->transferStats = TransferStats();
+    this->antiEntropyStats = AntiEntropyStats();
+    this->filterStats = FilterStats();
+    this->rebalanceStats = RebalanceStats();
+    this->lastSlice = -1;
+    if (par->SNAPSHOT_PERIOD > 0) {
+        // A snapshot left by an earlier run is not ours
+        remove(snapshotPath().c_str());
+    }
 }
 
 /**
@@ -30,61 +47,232 @@ MP2Node::~MP2Node() {
  * FUNCTION NAME: updateRing
  *
  * DESCRIPTION: This function does the following:
- * 				1) Gets the current membership list from the Membership Protocol (MP1Node)
- * 				   The membership list is returned as a vector of Nodes. See Node class in Node.h
- * 				2) Constructs the ring based on the membership list
- * 				3) Calls the Stabilization Protocol
+ * 				1) Takes the membership changes published by the Membership Protocol (MP1Node)
+ * 				   since the last call. Nothing is done when the membership epoch has not moved
+ * 				2) Patches the sorted ring in place with the joined, left and failed members.
+ * 				   The ring is copied before the first change only, and events that cancel
+ * 				   out, such as a member failing and rejoining within a round, are told
+ * 				   apart by the member count and checksum of the ring being unchanged
+ * 				3) Calls the Stabilization Protocol for the key ranges whose replicas changed,
+ * 				   or, the first time we are in the ring after joining, catches up instead
  */
 void MP2Node::updateRing() {
-    /*
-     * Implement this. Parts of it are already implemented
-     */
-    vector <Node> curMemList;
-    bool change = false;
+    if (pendingEvents.empty()) {
+        return;
+    }
 
-    /*
-     *  Step 1. Get the current membership list from Membership Protocol / MP1
-     */
-    curMemList = getMembershipList();
+    vector <Node> oldRing;
+    RingIndex oldIndex;
+    size_t oldMembers = ringMembers;
+    unsigned long long oldChecksum = ringChecksum;
+    bool changed = false;
+    vector <KeyRange> affected;
+    std::for_each(pendingEvents.begin(), pendingEvents.end(), [&](const MembershipEvent &event) {
+        if (!changed && inRing(Node(event.addr)) != (event.type == MEMBER_JOINED)) {
+            oldRing = ring;
+            oldIndex = ringIndex;
+            changed = true;
+        }
+        applyMembershipEvent(event, affected);
+        ringEpoch = event.epoch;
+    });
+    pendingEvents.clear();
+    if (!changed || (ringMembers == oldMembers && ringChecksum == oldChecksum)) {
+        return;
+    }
 
-    /*
-     * Step 2: Construct the ring
-     */
-    // Sort the list based on the hashCode
-    sort(curMemList.begin(), curMemList.end());
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    indexRing(ring, ringIndex);
+    placementCost.builds++;
+    placementCost.buildMicros += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    if (par->PLACEMENT_STATS) {
+        measurePlacement(oldRing, oldIndex);
+    }
+    findNeighbors();
+    buildMerkleTrees();
+
+    if (catchUpPending) {
+        if (ringNodes(ring) >= REPLICAS && inRing(Node(getMemberNode()->addr))) {
+            catchUp();
+        }
+        return;
+    }
+    if (!ht->isEmpty()) {
+        stabilizationProtocol(oldRing, oldIndex, affected);
+    }
+}
 
+/**
+ * FUNCTION NAME: membershipChanged
+ *
+ * DESCRIPTION: Queue a membership change until the next updateRing. Our own leave is
+ * 				acted upon at once, as the node stops right after
+ */
+void MP2Node::membershipChanged(const MembershipEvent &event) {
+    if (event.type == MEMBER_LEFT &&
+        !memcmp(event.addr.addr, memberNode->addr.addr, sizeof(memberNode->addr.addr))) {
+        handOff();
+        ringEpoch = event.epoch;
+        return;
+    }
+    pendingEvents.push_back(event);
+}
 
-    ring.clear();
-    ring = curMemList;
-    /*
-     * Step 3: Run the stabilization protocol IF REQUIRED
-     */
-    // Run stabilization protocol if the hash table size is greater than zero and if there has been a changed in the ring
-    stabilizationProtocol();
+/**
+ * FUNCTION NAME: handOff
+ *
+ * DESCRIPTION: Send every key we hold to the nodes that become its replicas once we are
+ * 				out of the ring, before we leave. The survivors run the stabilization
+ * 				protocol for our leave as well, which only repeats these CREATEs.
+ */
+void MP2Node::handOff() {
+    updateRing();
+
+    Node self(getMemberNode()->addr);
+    vector <Node> remaining;
+    std::copy_if(ring.begin(), ring.end(), std::back_inserter(remaining), [&self](const Node &n) {
+        return memcmp(n.nodeAddress.addr, self.nodeAddress.addr, sizeof(self.nodeAddress.addr));
+    });
+
+    RingIndex remainingIndex;
+    indexRing(remaining, remainingIndex);
+
+    vector<pair<size_t, string>> keys;
+    keyIndex.keysIn(0, 0, keys);
+    TransferQueue queue;
+    std::for_each(keys.begin(), keys.end(), [&](const pair<size_t, string> &key) {
+        ReplicaSet oldReplicas = replicasOn(ringIndex, key.first);
+        ReplicaSet newReplicas = replicasOn(remainingIndex, key.first);
+        for (size_t i = 0; i < newReplicas.count; i++) {
+            Node &replica = remaining[newReplicas.index[i]];
+            if (!holds(ring, oldReplicas, replica.nodeAddress)) {
+                queueTransfer(queue, replica.nodeAddress, key.second, false);
+            }
+        }
+    });
+    // We stop right after, so nobody would be there for the acknowledgements
+    long sent = transferStats.messages;
+    long records = transferStats.records;
+    std::for_each(queue.begin(), queue.end(), [this](pair<Address, vector<TransferKey>> &keys) {
+        streamKeys(keys.first, keys.second, false);
+    });
+    sent = transferStats.messages - sent;
+    records = transferStats.records - records;
+    if (!ht->isEmpty()) {
+        log->LOG(&memberNode->addr, "#STATSLOG# leaving: handed %ld records off in %ld messages, of %lu keys held",
+                 records, sent, ht->currentSize());
+    }
+
+    if (remaining.size() < ring.size()) {
+        ringMembers--;
+        ringChecksum ^= self.nodeHashCode;
+    }
+    ring.swap(remaining);
+    ringIndex = remainingIndex;
+    findNeighbors();
+    merkleTrees.clear();
+    offers.clear();
+    rebalance.ranges.clear();
+}
+
+/**
+ * FUNCTION NAME: applyMembershipEvent
+ *
+ * DESCRIPTION: Insert or remove the tokens of one member in the sorted ring, keep its
+ * 				member count and checksum, and record the ranges of keys whose replica set
+ * 				changed. The ranges are taken on the ring holding the member: after a join,
+ * 				before a removal
+ */
+void MP2Node::applyMembershipEvent(const MembershipEvent &event, vector <KeyRange> &affected) {
+    vector <Node> tokens = tokensOf(event.addr);
+    bool present = inRing(tokens[0]);
+    if (present == (event.type == MEMBER_JOINED)) {
+        return;
+    }
+
+    if (event.type == MEMBER_JOINED) {
+        insertTokens(ring, tokens);
+    }
+    ringMembers += event.type == MEMBER_JOINED ? 1 : -1;
+    ringChecksum ^= tokens[0].nodeHashCode;
+    std::for_each(tokens.begin(), tokens.end(), [this, &affected](const Node &token) {
+        size_t index = std::lower_bound(ring.begin(), ring.end(), token) - ring.begin();
+        affected.push_back(affectedRange(ring, index));
+    });
+    if (event.type != MEMBER_JOINED) {
+        ring.erase(std::remove_if(ring.begin(), ring.end(), [&event](const Node &n) {
+            return !memcmp(n.nodeAddress.addr, event.addr.addr, sizeof(event.addr.addr));
+        }), ring.end());
+    }
+}
+
+/**
+ * FUNCTION NAME: affectedRange
+ *
+ * DESCRIPTION: Keys whose replica set contains the member of token r[index] through that
+ * 				token: the range back to the token at which REPLICAS other members have
+ * 				been passed, as replicas are the first REPLICAS distinct members from the
+ * 				key on. With zones, replicas skip nodes of zones already holding a copy,
+ * 				and with placements other than the ring, a member moves keys anywhere, so
+ * 				any range may be affected
+ */
+KeyRange MP2Node::affectedRange(vector <Node> &r, size_t index) {
+    KeyRange range;
+    range.to = r[index].nodeHashCode;
+    range.from = range.to;
+    if (par->ZONE_COUNT > 1 || par->PLACEMENT != RING_PLACEMENT) {
+        return range;
+    }
+    vector <Node> passed;
+    for (size_t k = 1; k < r.size(); k++) {
+        Node &prev = r[(index + r.size() - k) % r.size()];
+        bool seen = !memcmp(prev.nodeAddress.addr, r[index].nodeAddress.addr, sizeof(prev.nodeAddress.addr)) ||
+                    std::any_of(passed.begin(), passed.end(), [&prev](const Node &n) {
+                        return !memcmp(n.nodeAddress.addr, prev.nodeAddress.addr, sizeof(n.nodeAddress.addr));
+                    });
+        if (seen) {
+            continue;
+        }
+        passed.push_back(prev);
+        if (passed.size() == REPLICAS) {
+            range.from = prev.nodeHashCode;
+            break;
+        }
+    }
+    return range;
 }
 
 /**
- * FUNCTION NAME: getMemberhipList
+ * FUNCTION NAME: tokensOf
  *
- * DESCRIPTION: This function goes through the membership list from the Membership protocol/MP1 and
- * 				i) generates the hash code for each member
- * 				ii) populates the ring member in MP2Node class
- * 				It returns a vector of Nodes. Each element in the vector contain the following fields:
- * 				a) Address of the node
- * 				b) Hash code obtained by consistent hashing of the Address
+ * DESCRIPTION: The VNODES tokens of the member at address
  */
-vector <Node> MP2Node::getMembershipList() {
-    unsigned int i;
-    vector <Node> curMemList;
-    for (i = 0; i < this->memberNode->memberList.size(); i++) {
-        Address addressOfThisMember;
-        int id = this->memberNode->memberList.at(i).getid();
-        short port = this->memberNode->memberList.at(i).getport();
-        memcpy(&addressOfThisMember.addr[0], &id, sizeof(int));
-        memcpy(&addressOfThisMember.addr[4], &port, sizeof(short));
-        curMemList.emplace_back(Node(addressOfThisMember));
+vector <Node> MP2Node::tokensOf(const Address &address) {
+    vector <Node> tokens;
+    for (int vnode = 0; vnode < par->VNODES; vnode++) {
+        tokens.emplace_back(Node(address, vnode));
     }
-    return curMemList;
+    return tokens;
+}
+
+/**
+ * FUNCTION NAME: insertTokens
+ *
+ * DESCRIPTION: Insert tokens in the sorted ring r
+ */
+void MP2Node::insertTokens(vector <Node> &r, vector <Node> &tokens) {
+    std::for_each(tokens.begin(), tokens.end(), [&r](const Node &token) {
+        r.insert(std::lower_bound(r.begin(), r.end(), token), token);
+    });
+}
+
+/**
+ * FUNCTION NAME: ringNodes
+ *
+ * DESCRIPTION: Returns the number of members on ring r
+ */
+size_t MP2Node::ringNodes(vector <Node> &r) {
+    return r.size() / par->VNODES;
 }
 
 /**
@@ -96,10 +284,11 @@ vector <Node> MP2Node::getMembershipList() {
  * RETURNS:
  * size_t position on the ring
  */
-size_t MP2Node::hashFunction(string key) {
-    std::hash <string> hashFunc;
-    size_t ret = hashFunc(key);
-    return ret % RING_SIZE;
+size_t MP2Node::hashFunction(string_view key) {
+    // Hashes as std::hash <string> does, without a copy of the key, then spreads the
+    // hash over the whole ring as the tokens are
+    std::hash <string_view> hashFunc;
+    return Node::mixHash(hashFunc(key));
 }
 
 /**
@@ -112,11 +301,11 @@ size_t MP2Node::hashFunction(string key) {
  * 				3) Sends a message to the replica
  */
 void MP2Node::clientCreate(string key, string value) {
-    vector<Node> nodes = findNodes(key);
+    ReplicaSet replicas = replicasOn(ringIndex, hashFunction(key));
     Message message(g_transID++, this->getMemberNode()->addr, CREATE, key, value);
     recordTransaction(message);
-    for(Node node : nodes) {
-        dispatchMessage(message, node.getAddress());
+    for (size_t i = 0; i < replicas.count; i++) {
+        dispatchMessage(message, ring[replicas.index[i]].getAddress());
     }
 }
 
@@ -130,11 +319,11 @@ void MP2Node::clientCreate(string key, string value) {
  * 				3) Sends a message to the replica
  */
 void MP2Node::clientRead(string key) {
-    vector<Node> nodes = findNodes(key);
+    ReplicaSet replicas = replicasOn(ringIndex, hashFunction(key));
     Message message(g_transID++, getMemberNode()->addr, READ, key);
     recordTransaction(message);
-    for(Node node : nodes) {
-        dispatchMessage(message, node.getAddress());
+    for (size_t i = 0; i < replicas.count; i++) {
+        dispatchMessage(message, ring[replicas.index[i]].getAddress());
     }
 }
 
@@ -148,11 +337,11 @@ void MP2Node::clientRead(string key) {
  * 				3) Sends a message to the replica
  */
 void MP2Node::clientUpdate(string key, string value) {
-    vector<Node> nodes = findNodes(key);
+    ReplicaSet replicas = replicasOn(ringIndex, hashFunction(key));
     Message message(g_transID++, getMemberNode()->addr, UPDATE, key, value);
     recordTransaction(message);
-    for(Node node : nodes) {
-        dispatchMessage(message, node.getAddress());
+    for (size_t i = 0; i < replicas.count; i++) {
+        dispatchMessage(message, ring[replicas.index[i]].getAddress());
     }
 }
 
@@ -166,11 +355,11 @@ void MP2Node::clientUpdate(string key, string value) {
  * 				3) Sends a message to the replica
  */
 void MP2Node::clientDelete(string key) {
-    vector<Node> nodes = findNodes(key);
+    ReplicaSet replicas = replicasOn(ringIndex, hashFunction(key));
     Message message(g_transID++, getMemberNode()->addr, DELETE, key);
     recordTransaction(message);
-    for(Node node : nodes) {
-        dispatchMessage(message, node.getAddress());
+    for (size_t i = 0; i < replicas.count; i++) {
+        dispatchMessage(message, ring[replicas.index[i]].getAddress());
     }
 }
 
@@ -182,9 +371,17 @@ void MP2Node::clientDelete(string key) {
  * 			   	1) Inserts key value into the local hash table
  * 			   	2) Return true or false based on success or failure
  */
-bool MP2Node::createKeyValue(string key, string value, ReplicaType replica) {
-    // Insert key, value, replicaType into the hash table
-    return ht->create(key, value);
+bool MP2Node::createKeyValue(string_view key, string_view value, ReplicaType replica) {
+    // Insert key, value, replicaType into the hash table. A key already there is left as
+    // it is, and so are its index entry, version, Merkle leaf and filter cells
+    if (!ht->create(key, value)) {
+        return false;
+    }
+    size_t pos = hashFunction(key);
+    keyIndex.insert(key, pos);
+    versions.touch(key, pos, par->getcurrtime(), false);
+    entryChanged(pos, 0, hashingEntries() ? MerkleTree::entryHash(key, value) : 0);
+    return true;
 }
 
 /**
@@ -195,9 +392,9 @@ bool MP2Node::createKeyValue(string key, string value, ReplicaType replica) {
  * 			    1) Read key from local hash table
  * 			    2) Return value
  */
-string MP2Node::readKey(string key) {
-    // Read key from local hash table and return value
-    return ht->read(key);
+string_view MP2Node::readKey(string_view key) {
+    // Read key from local hash table and return value, without copying it
+    return ht->find(key);
 }
 
 /**
@@ -208,9 +405,16 @@ string MP2Node::readKey(string key) {
  * 				1) Update the key to the new value in the local hash table
  * 				2) Return true or false based on success or failure
  */
-bool MP2Node::updateKeyValue(string key, string value, ReplicaType replica) {
+bool MP2Node::updateKeyValue(string_view key, string_view value, ReplicaType replica) {
     // Update key in local hash table and return true or false
-    return ht->update(key, value);
+    uint64_t removed = hashingEntries() ? MerkleTree::entryHash(key, ht->find(key)) : 0;
+    if (!ht->update(key, value)) {
+        return false;
+    }
+    size_t pos = hashFunction(key);
+    versions.touch(key, pos, par->getcurrtime(), false);
+    entryChanged(pos, removed, hashingEntries() ? MerkleTree::entryHash(key, value) : 0);
+    return true;
 }
 
 /**
@@ -221,9 +425,17 @@ bool MP2Node::updateKeyValue(string key, string value, ReplicaType replica) {
  * 				1) Delete the key from the local hash table
  * 				2) Return true or false based on success or failure
  */
-bool MP2Node::deletekey(string key) {
+bool MP2Node::deletekey(string_view key) {
     // Delete the key from the local hash table
-    return ht->deleteKey(key);
+    uint64_t removed = hashingEntries() ? MerkleTree::entryHash(key, ht->find(key)) : 0;
+    if (!ht->deleteKey(key)) {
+        return false;
+    }
+    size_t pos = hashFunction(key);
+    keyIndex.erase(key, pos);
+    versions.touch(key, pos, par->getcurrtime(), true);
+    entryChanged(pos, removed, 0);
+    return true;
 }
 
 /**
@@ -254,10 +466,15 @@ void MP2Node::checkMessages() {
         size = memberNode->mp2q.front().size;
         memberNode->mp2q.pop();
 
-        string message(data, data + size);
-
-        Message msg(message);
-        handleMessage(msg);
+        // The message is handled in place and the buffer freed after
+        MessageView msg;
+        if (msg.parse(data, size)) {
+            if (piggyback && !msg.piggyback.empty()) {
+                piggyback->incoming(msg.piggyback);
+            }
+            handleMessage(msg);
+        }
+        free(data);
 
     }
 
@@ -266,37 +483,301 @@ void MP2Node::checkMessages() {
      * get QUORUM replies
      */
     checkForQuorum();
+
+    if (lastSlice != par->getcurrtime()) {
+        rebalanceSlice();
+    }
+    pumpTransfers();
+    expireOffers();
+
+    // Nodes take turns, rather than all exchanging trees in the same round
+    if (par->ANTI_ENTROPY_PERIOD > 0 && (par->getcurrtime() + *(int *) memberNode->addr.addr) % par->ANTI_ENTROPY_PERIOD == 0) {
+        startAntiEntropy();
+    }
+
+    if (par->SNAPSHOT_PERIOD > 0 && par->getcurrtime() % par->SNAPSHOT_PERIOD == 0) {
+        saveSnapshot();
+    }
+
+    if (par->getcurrtime() % TOMBSTONE_SWEEP == 0) {
+        sweepTombstones();
+    }
+}
+
+/**
+ * FUNCTION NAME: sweepTombstones
+ *
+ * DESCRIPTION: Forget the deletes made more than TOMBSTONE_TTL rounds ago, and those of the
+ * 				keys of ranges we no longer replicate. The ring is only looked at once we
+ * 				are settled in it
+ */
+void MP2Node::sweepTombstones() {
+    long horizon = par->TOMBSTONE_TTL > 0 ? par->getcurrtime() - par->TOMBSTONE_TTL : -1;
+    bool settled = !catchUpPending && !ring.empty();
+    Address self = memberNode->addr;
+    versions.dropTombstones(horizon, [this, settled, &self](string_view key) {
+        return !settled || holds(ring, replicasOn(ringIndex, hashFunction(key)), self);
+    });
 }
 
 /**
  * FUNCTION NAME: findNodes
  *
  * DESCRIPTION: Find the replicas of the given keyfunction
- * 				This function is responsible for finding the replicas of a key
+ * 				This function is responsible for finding the replicas of a key. The set
+ * 				refers to the current ring, so it is only good until the ring changes
  */
-vector <Node> MP2Node::findNodes(string key) {
-    size_t pos = hashFunction(key);
-    vector <Node> addr_vec;
-    if (ring.size() >= 3) {
-        // if pos <= min || pos > max, the leader is the min
-        if (pos <= ring.at(0).getHashCode() || pos > ring.at(ring.size() - 1).getHashCode()) {
-            addr_vec.emplace_back(ring.at(0));
-            addr_vec.emplace_back(ring.at(1));
-            addr_vec.emplace_back(ring.at(2));
-        } else {
-            // go through the ring until pos <= node
-            for (int i = 1; i < ring.size(); i++) {
-                Node addr = ring.at(i);
-                if (pos <= addr.getHashCode()) {
-                    addr_vec.emplace_back(addr);
-                    addr_vec.emplace_back(ring.at((i + 1) % ring.size()));
-                    addr_vec.emplace_back(ring.at((i + 2) % ring.size()));
-                    break;
-                }
+ReplicaSet MP2Node::findNodes(string_view key) {
+    return replicasOn(ringIndex, hashFunction(key));
+}
+
+/**
+ * FUNCTION NAME: replicaAddress
+ *
+ * DESCRIPTION: Address of the i-th replica of a set found by findNodes
+ */
+Address *MP2Node::replicaAddress(const ReplicaSet &replicas, size_t i) {
+    assert(i < replicas.count);
+    return ring[replicas.index[i]].getAddress();
+}
+
+/**
+ * FUNCTION NAME: replicaSetAt
+ *
+ * DESCRIPTION: The REPLICAS nodes of ring r responsible for the keys of r[order[first]]:
+ * 				the member of that token and the members of the tokens after it in order,
+ * 				each member once. With zones, successors in a zone that already holds a
+ * 				copy are passed over while other zones remain, so the copies land in
+ * 				different failure domains
+ */
+ReplicaSet MP2Node::replicaSetAt(vector <Node> &r, const vector <size_t> &order, size_t first) {
+    ReplicaSet replicas;
+    replicas.count = 0;
+    if (ringNodes(r) < REPLICAS) {
+        return replicas;
+    }
+    auto chosen = [&r, &replicas](const Node &node) {
+        for (size_t i = 0; i < replicas.count; i++) {
+            if (!memcmp(r[replicas.index[i]].nodeAddress.addr, node.nodeAddress.addr, sizeof(node.nodeAddress.addr))) {
+                return true;
+            }
+        }
+        return false;
+    };
+    if (par->ZONE_COUNT <= 1) {
+        for (size_t i = 0; i < order.size() && replicas.count < REPLICAS; i++) {
+            size_t at = order[(first + i) % order.size()];
+            if (!chosen(r[at])) {
+                replicas.index[replicas.count++] = at;
+            }
+        }
+        return replicas;
+    }
+
+    auto zoneUsed = [this, &r, &replicas](int zone) {
+        for (size_t i = 0; i < replicas.count; i++) {
+            if (par->zoneOf(*(int *) r[replicas.index[i]].nodeAddress.addr) == zone) {
+                return true;
+            }
+        }
+        return false;
+    };
+    for (size_t i = 0; i < order.size() && replicas.count < REPLICAS; i++) {
+        size_t at = order[(first + i) % order.size()];
+        if (!zoneUsed(par->zoneOf(*(int *) r[at].nodeAddress.addr))) {
+            replicas.index[replicas.count++] = at;
+        }
+    }
+    // Fewer zones than replicas: the rest go to the next nodes
+    for (size_t i = 0; i < order.size() && replicas.count < REPLICAS; i++) {
+        size_t at = order[(first + i) % order.size()];
+        if (!chosen(r[at])) {
+            replicas.index[replicas.count++] = at;
+        }
+    }
+    return replicas;
+}
+
+/**
+ * FUNCTION NAME: indexRing
+ *
+ * DESCRIPTION: Build the index of ring r for the placement of Params. On the ring, a key
+ * 				goes to the replicas of the first token at or after it. Otherwise a key
+ * 				picks a primary member, from the Maglev table or by jump consistent
+ * 				hashing, and its replicas are the primary and the members after it in
+ * 				address order
+ */
+void MP2Node::indexRing(vector <Node> &r, RingIndex &index) {
+    index.placement = par->PLACEMENT;
+    index.positions.clear();
+    index.members.clear();
+    index.replicas.clear();
+    index.table.clear();
+    if (par->PLACEMENT == RING_PLACEMENT) {
+        for (size_t i = 0; i < r.size(); i++) {
+            index.positions.push_back(r[i].nodeHashCode);
+            index.members.push_back(i);
+        }
+        for (size_t i = 0; i < r.size(); i++) {
+            index.replicas.push_back(replicaSetAt(r, index.members, i));
+        }
+        index.members.clear();
+        return;
+    }
+
+    for (size_t i = 0; i < r.size(); i++) {
+        if (r[i].vnode == 0) {
+            index.members.push_back(i);
+        }
+    }
+    std::sort(index.members.begin(), index.members.end(), [&r](size_t a, size_t b) {
+        return memcmp(r[a].nodeAddress.addr, r[b].nodeAddress.addr, sizeof(r[a].nodeAddress.addr)) < 0;
+    });
+    for (size_t m = 0; m < index.members.size(); m++) {
+        index.replicas.push_back(replicaSetAt(r, index.members, m));
+    }
+    if (par->PLACEMENT == MAGLEV_PLACEMENT && !index.members.empty()) {
+        buildMaglevTable(r, index.members, index.table);
+    }
+}
+
+/**
+ * FUNCTION NAME: buildMaglevTable
+ *
+ * DESCRIPTION: Fill the MAGLEV_TABLE_SIZE slots of table with the positions in members of
+ * 				their owners, as Maglev does: each member walks its own permutation of the
+ * 				slots, given by an offset and a skip hashed from its address, and members
+ * 				take turns claiming the next free slot of theirs. Every member gets the
+ * 				same share of slots, give or take one, and a membership change reassigns
+ * 				few slots besides those of the member joining or leaving
+ */
+void MP2Node::buildMaglevTable(vector <Node> &r, const vector <size_t> &members, vector <uint32_t> &table) {
+    size_t n = members.size();
+    vector <size_t> offset(n);
+    vector <size_t> skip(n);
+    vector <size_t> next(n, 0);
+    for (size_t m = 0; m < n; m++) {
+        size_t hash = r[members[m]].nodeHashCode;
+        offset[m] = hash % MAGLEV_TABLE_SIZE;
+        skip[m] = Node::mixHash(hash) % (MAGLEV_TABLE_SIZE - 1) + 1;
+    }
+
+    table.assign(MAGLEV_TABLE_SIZE, UINT32_MAX);
+    size_t filled = 0;
+    while (true) {
+        for (size_t m = 0; m < n; m++) {
+            size_t slot;
+            do {
+                slot = (offset[m] + next[m] * skip[m]) % MAGLEV_TABLE_SIZE;
+                next[m]++;
+            } while (table[slot] != UINT32_MAX);
+            table[slot] = (uint32_t) m;
+            if (++filled == MAGLEV_TABLE_SIZE) {
+                return;
+            }
+        }
+    }
+}
+
+/**
+ * FUNCTION NAME: jumpHash
+ *
+ * DESCRIPTION: Jump consistent hash of Lamping and Veach: the bucket of key among buckets,
+ * 				in O(log buckets) steps without any table. Adding a bucket moves only the
+ * 				keys that land in it, but removing any bucket but the last renumbers the
+ * 				ones after it
+ */
+uint32_t MP2Node::jumpHash(uint64_t key, uint32_t buckets) {
+    int64_t bucket = -1;
+    int64_t jump = 0;
+    while (jump < (int64_t) buckets) {
+        bucket = jump;
+        key = key * 2862933555777941757ULL + 1;
+        jump = (int64_t) ((bucket + 1) * ((double) (1LL << 31) / (double) ((key >> 33) + 1)));
+    }
+    return (uint32_t) bucket;
+}
+
+/**
+ * FUNCTION NAME: replicasOn
+ *
+ * DESCRIPTION: The replicas of ring position pos on the ring index was built from. On the
+ * 				ring those of the first token at or after pos, found by binary search; with
+ * 				the other placements those of the primary member, found in constant time.
+ * 				Allocates nothing
+ */
+ReplicaSet MP2Node::replicasOn(const RingIndex &index, size_t pos) {
+    if (index.replicas.empty()) {
+        ReplicaSet none;
+        none.count = 0;
+        return none;
+    }
+    if (index.placement == MAGLEV_PLACEMENT) {
+        return index.replicas[index.table[pos % MAGLEV_TABLE_SIZE]];
+    }
+    if (index.placement == JUMP_PLACEMENT) {
+        return index.replicas[jumpHash(pos, (uint32_t) index.replicas.size())];
+    }
+    // if pos <= min || pos > max, the leader is the min
+    size_t first = std::lower_bound(index.positions.begin(), index.positions.end(), pos) - index.positions.begin();
+    return index.replicas[first == index.positions.size() ? 0 : first];
+}
+
+/**
+ * FUNCTION NAME: measurePlacement
+ *
+ * DESCRIPTION: Record the share of the replicas, and of the primaries, that the last
+ * 				membership change moved to another node, over PLACEMENT_SAMPLES ring
+ * 				positions looked up before and after it. Only run with PLACEMENT_STATS, as
+ * 				it costs far more than building the index
+ */
+void MP2Node::measurePlacement(vector <Node> &oldRing, RingIndex &oldIndex) {
+    if (ringNodes(oldRing) < REPLICAS || ringNodes(ring) < REPLICAS) {
+        return;
+    }
+    long moved = 0;
+    long owners = 0;
+    for (size_t i = 0; i < PLACEMENT_SAMPLES; i++) {
+        size_t pos = Node::mixHash(i);
+        ReplicaSet before = replicasOn(oldIndex, pos);
+        ReplicaSet after = replicasOn(ringIndex, pos);
+        for (size_t j = 0; j < after.count; j++) {
+            if (!holds(oldRing, before, ring[after.index[j]].nodeAddress)) {
+                moved++;
             }
         }
+        if (memcmp(oldRing[before.index[0]].nodeAddress.addr, ring[after.index[0]].nodeAddress.addr,
+                   sizeof(ring[after.index[0]].nodeAddress.addr))) {
+            owners++;
+        }
+    }
+    placementCost.changes++;
+    placementCost.movedReplicas += (double) moved / (PLACEMENT_SAMPLES * REPLICAS);
+    placementCost.movedOwners += (double) owners / PLACEMENT_SAMPLES;
+}
+
+/**
+ * FUNCTION NAME: holds
+ *
+ * DESCRIPTION: Whether the member at address is one of replicas, looked up on ring r
+ */
+bool MP2Node::holds(vector <Node> &r, const ReplicaSet &replicas, const Address &address) {
+    for (size_t i = 0; i < replicas.count; i++) {
+        if (!memcmp(r[replicas.index[i]].nodeAddress.addr, address.addr, sizeof(address.addr))) {
+            return true;
+        }
     }
-    return addr_vec;
+    return false;
+}
+
+/**
+ * FUNCTION NAME: inRing
+ *
+ * DESCRIPTION: Whether node is part of the current ring
+ */
+bool MP2Node::inRing(const Node &node) {
+    vector<Node>::iterator it = std::lower_bound(ring.begin(), ring.end(), node);
+    return it != ring.end() && !memcmp(it->nodeAddress.addr, node.nodeAddress.addr, sizeof(node.nodeAddress.addr));
 }
 
 /**
@@ -327,91 +808,1444 @@ int MP2Node::enqueueWrapper(void *env, char *buff, int size) {
  *
  * DESCRIPTION: This runs the stabilization protocol in case of Node joins and leaves
  * 				It ensures that there always 3 copies of all keys in the DHT at all times
- * 				The function does the following:
- *				1) Ensures that there are three "CORRECT" replicas of all the keys in spite of failures and joins
+ * 				The work is a background task, moving at most REBALANCE_KEYS keys and
+ * 				REBALANCE_BYTES bytes a round so that CRUD traffic goes on meanwhile:
+ *				1) Adds the affected ranges to the task, starting one from oldRing if none
+ *				   is under way. A change coming mid-task extends it: the arcs left keep
+ *				   their cursors, and every key still to do is compared from the ring
+ *				   the task started on to the current one
+ *				2) Runs the first slice of the task at once; the others run a round each,
+ *				   from checkMessages
  *				Note:- "CORRECT" replicas implies that every key is replicated in its two neighboring nodes in the ring
  */
-void MP2Node::stabilizationProtocol() {
-    vector<Node> newHros = getNewHROs();
-    vector<Node> newHMRs = getNewHMRs();
-    std::for_each(ht->hashTable.begin(), ht->hashTable.end(), [this, newHros, newHMRs](pair<string, string> kv) {
-        vector<Node> replicas = findNodes(kv.first);
-        if(getMemberNode()->addr == *(replicas[1].getAddress()) || newHros.size() >= 2) {
-            std::for_each(replicas.begin(), replicas.end(), [this, newHros, kv](const Node& replica) {
-                std::vector<Node>::const_iterator it = std::find_if(newHros.begin(), newHros.end(),
-                                                              [replica](const Node& hro) {
-                                                                  return hro.nodeHashCode == replica.nodeHashCode;
-                                                              });
-                if (it != newHros.end())
-                    sendData(*it, kv.first);
-            });
+void MP2Node::stabilizationProtocol(vector <Node> &oldRing, RingIndex &oldIndex, vector <KeyRange> &affected) {
+    if (rebalance.ranges.empty()) {
+        rebalance.oldRing = oldRing;
+        rebalance.oldIndex = oldIndex;
+        rebalance.started = par->getcurrtime();
+        rebalance.scanned = 0;
+        rebalance.queued = 0;
+        rebalance.slices = 0;
+        rebalance.restarts = 0;
+        rebalanceStats.tasks++;
+    } else {
+        rebalance.restarts++;
+        rebalanceStats.restarts++;
+    }
+    rebalance.ranges.insert(rebalance.ranges.end(), affected.begin(), affected.end());
+    mergeRanges(rebalance.ranges);
+    rebalanceSlice();
+}
 
-            return;
+/**
+ * FUNCTION NAME: mergeRanges
+ *
+ * DESCRIPTION: Merge ranges that overlap or touch, so that no key is gone through twice.
+ * 				The result is in ring order; the whole ring is (SIZE_MAX, SIZE_MAX], whose
+ * 				keys the key index gives from position 0 on
+ */
+void MP2Node::mergeRanges(vector <KeyRange> &ranges) {
+    // Closed intervals [first, last] that do not wrap
+    vector<pair<size_t, size_t>> spans;
+    std::for_each(ranges.begin(), ranges.end(), [&spans](const KeyRange &range) {
+        if (range.from == range.to) {
+            spans.emplace_back(0, SIZE_MAX);
+        } else if (range.from < range.to) {
+            spans.emplace_back(range.from + 1, range.to);
+        } else {
+            if (range.from != SIZE_MAX) {
+                spans.emplace_back(range.from + 1, SIZE_MAX);
+            }
+            spans.emplace_back(0, range.to);
         }
+    });
+    std::sort(spans.begin(), spans.end());
 
-        if(getMemberNode()->addr == *(replicas[0].getAddress())) {
-            std::for_each(replicas.begin(), replicas.end(), [this, newHMRs, kv](const Node& replica) {
-                std::vector<Node>::const_iterator it = std::find_if(newHMRs.begin(), newHMRs.end(),
-                                                              [replica](const Node& hmr) {
-                                                                  return hmr.nodeHashCode == replica.nodeHashCode;
-                                                              });
-                if (it != newHMRs.end())
-                    sendData(*it, kv.first);
-            });
-            return;
+    ranges.clear();
+    for (size_t i = 0; i < spans.size(); i++) {
+        if (!ranges.empty() && (ranges.back().to == SIZE_MAX || spans[i].first <= ranges.back().to + 1)) {
+            ranges.back().to = std::max(ranges.back().to, spans[i].second);
+        } else {
+            ranges.push_back(KeyRange{spans[i].first - 1, spans[i].second});
         }
+    }
+}
 
-        /*if(Node(getMemberNode()->addr).nodeHashCode != replicas[2].getHashCode()) {
-            ht->deleteKey(kv.first);
-            return;
-        }*/
+/**
+ * FUNCTION NAME: rebalanceSlice
+ *
+ * DESCRIPTION: Run a slice of the rebalancing task, once a round while one is under way:
+ *				1) Takes the keys of the arcs left from the key index, in ring order from
+ *				   the cursor of each, until REBALANCE_KEYS are gone through or
+ *				   REBALANCE_BYTES of records are queued. The keys outside the arcs are
+ *				   not looked at, their replicas did not change
+ *				2) Decides for each key which new replicas we send it to
+ *				3) Streams the keys to send to each new replica as one range transfer.
+ *				   With STABILIZE_FILTER, those it probably holds already are confirmed
+ *				   against its filters first and left out
+ */
+void MP2Node::rebalanceSlice() {
+    if (rebalance.ranges.empty()) {
+        return;
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    size_t keyBudget = par->REBALANCE_KEYS > 0 ? (size_t) par->REBALANCE_KEYS : SIZE_MAX;
+    size_t byteBudget = par->REBALANCE_BYTES > 0 ? (size_t) par->REBALANCE_BYTES : SIZE_MAX;
+    size_t scanned = 0;
+    size_t bytes = 0;
+    long queued = 0;
+    TransferQueue queue;
+    vector<pair<size_t, string>> keys;
+    while (!rebalance.ranges.empty() && scanned < keyBudget && bytes < byteBudget) {
+        KeyRange &range = rebalance.ranges.front();
+        keys.clear();
+        bool exhausted = keyIndex.keysIn(range.from, range.to, keys, keyBudget - scanned);
+        size_t i = 0;
+        for (; i < keys.size(); i++) {
+            // Keys at one position are done together, the cursor being a position
+            if (bytes >= byteBudget && i > 0 && keys[i].first != keys[i - 1].first) {
+                break;
+            }
+            size_t sent = rebalanceKey(keys[i].first, keys[i].second, queue);
+            bytes += sent;
+            queued += sent > 0;
+        }
+        scanned += i;
+        if ((exhausted && i == keys.size()) || (i > 0 && keys[i - 1].first == range.to)) {
+            rebalance.ranges.erase(rebalance.ranges.begin());
+        } else if (i > 0) {
+            range.from = keys[i - 1].first;
+        }
+    }
+    std::for_each(queue.begin(), queue.end(), [this](pair<Address, vector<TransferKey>> &keys) {
+        if (par->STABILIZE_FILTER && par->RANGE_TRANSFER) {
+            offerKeys(keys.first, keys.second);
+        } else {
+            streamKeys(keys.first, keys.second, true);
+        }
     });
+
+    double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    lastSlice = par->getcurrtime();
+    rebalance.scanned += scanned;
+    rebalance.queued += queued;
+    rebalance.slices++;
+    rebalanceStats.slices++;
+    rebalanceStats.scanned += scanned;
+    rebalanceStats.queued += queued;
+    rebalanceStats.bytes += bytes;
+    rebalanceStats.sliceMicros += micros;
+    rebalanceStats.maxSliceMicros = std::max(rebalanceStats.maxSliceMicros, micros);
+    if (rebalance.ranges.empty()) {
+        rebalanceStats.finished++;
+        rebalanceStats.rounds += par->getcurrtime() - rebalance.started;
+        if (rebalance.slices > 1) {
+            log->LOG(&memberNode->addr, "#STATSLOG# rebalanced: %ld keys gone through, %ld sent, in %ld slices over %d rounds, %ld ring changes on the way",
+                     rebalance.scanned, rebalance.queued, rebalance.slices, par->getcurrtime() - rebalance.started,
+                     rebalance.restarts);
+        }
+    }
+}
+
+/**
+ * FUNCTION NAME: rebalanceKey
+ *
+ * DESCRIPTION: Compare the replicas of the key at ring position pos on the ring the task
+ * 				started on with those on the ring. The first old replica that is still a
+ * 				replica (or, failing that, still in the ring) sends the key to the replicas
+ * 				that are new, nodes that just joined included: a joiner restored from a
+ * 				snapshot also pulls what it missed, but a lost CATCHUP or one sent on a
+ * 				partial ring would leave it without keys
+ *
+ * RETURNS:
+ * the bytes of the records queued, 0 if we are not the one sending the key
+ */
+size_t MP2Node::rebalanceKey(size_t pos, const string &key, TransferQueue &queue) {
+    Node self(getMemberNode()->addr);
+    vector <Node> &oldRing = rebalance.oldRing;
+    ReplicaSet oldReplicas = replicasOn(rebalance.oldIndex, pos);
+    ReplicaSet newReplicas = replicasOn(ringIndex, pos);
+
+    const Node *sender = &self;
+    size_t i = 0;
+    while (i < newReplicas.count && !holds(oldRing, oldReplicas, ring[newReplicas.index[i]].nodeAddress)) {
+        i++;
+    }
+    if (i < newReplicas.count) {
+        sender = &ring[newReplicas.index[i]];
+    } else {
+        for (i = 0; i < oldReplicas.count; i++) {
+            if (inRing(oldRing[oldReplicas.index[i]])) {
+                sender = &oldRing[oldReplicas.index[i]];
+                break;
+            }
+        }
+    }
+    if (memcmp(sender->nodeAddress.addr, self.nodeAddress.addr, sizeof(self.nodeAddress.addr))) {
+        return 0;
+    }
+
+    size_t bytes = 0;
+    for (i = 0; i < newReplicas.count; i++) {
+        Node &replica = ring[newReplicas.index[i]];
+        if (!holds(oldRing, oldReplicas, replica.nodeAddress) &&
+            memcmp(replica.nodeAddress.addr, self.nodeAddress.addr, sizeof(self.nodeAddress.addr))) {
+            queueTransfer(queue, replica.nodeAddress, key, false);
+            bytes += TransferBatch::recordSize(key, ht->find(key));
+        }
+    }
+    return bytes;
 }
 
 // coordinator dispatches messages to corresponding nodes
 void MP2Node::dispatchMessage (Message message, Address* address) {
-    emulNet->ENsend(&(getMemberNode()->addr), address, message.toString());
+    send(message, address);
 }
 
-void MP2Node::handleMessage(Message message) {
-    switch (message.type) {
-        case CREATE:
-            if(message.transID == -1) {
-                createKeyValue(message.key, message.value, PRIMARY);
-                /*if(amOwner(message.key)) {
-                    for(Node node: hasMyReplicas) {
-                        dispatchMessage(message, node.getAddress());
-                    }
-                }*/
-            } else {
-                if(createKeyValue(message.key, message.value, PRIMARY)) {
-                    log->logCreateSuccess(&(getMemberNode()->addr), false, message.transID, message.key, message.value);
-                    message.type = REPLY;
-                    dispatchMessage(message, &(message.fromAddr));
-                } else {
-                    log->logCreateFail(&(getMemberNode()->addr), false, message.transID, message.key, message.value);
-                }
-            }
-            break;
-
-        case READ:
-            {
-                string ret = readKey(message.key);
-                if(ret != "") {
-                    log->logReadSuccess(&(getMemberNode()->addr), false, message.transID, message.key, ret);
-                    Message reply(message.transID, getMemberNode()->addr, READREPLY, message.key, ret);
-                    dispatchMessage(reply, &(message.fromAddr));
-                } else {
-                    log->logReadFail(&(getMemberNode()->addr), false, message.transID, message.key);
-                }
-            }
-            break;
+/**
+ * FUNCTION NAME: send
+ *
+ * DESCRIPTION: Send a message, with the membership delta for address riding on it
+ */
+int MP2Node::send(Message &message, Address *address) {
+    MessageView view = message.view();
+    return send(view, address);
+}
 
-        case UPDATE:
+/**
+ * FUNCTION NAME: send
+ *
+ * DESCRIPTION: Send a message given as a view over its fields, encoding it into the
+ * 				buffer of this node
+ */
+int MP2Node::send(MessageView &message, Address *address) {
+    if (piggyback) {
+        piggybackBuffer.clear();
+        piggyback->outgoing(address, piggybackBuffer);
+        message.piggyback = piggybackBuffer;
+    }
+    wireBuffer.clear();
+    message.encode(wireBuffer);
+    return emulNet->ENsend(&(getMemberNode()->addr), address, &wireBuffer[0], (int) wireBuffer.size());
+}
+
+/**
+ * FUNCTION NAME: payloadBudget
+ *
+ * DESCRIPTION: Returns the bytes left for the value of a message whose key takes keySize
+ * 				bytes, once the network header, our header and the membership entries
+ * 				riding on it are counted. EmulNet refuses a message reaching MAX_MSG_SIZE,
+ * 				so the budget stops a byte short of it
+ */
+size_t MP2Node::payloadBudget(size_t keySize) {
+    size_t room = sizeof(en_msg) + WIRE_HEADER_SIZE + 3 * sizeof(uint16_t) + keySize +
+                  TRANSFER_PIGGYBACK_ROOM * std::max(par->PIGGYBACK_ENTRIES, 1) + 1;
+    return (size_t) par->MAX_MSG_SIZE > room + TRANSFER_PIGGYBACK_ROOM ? par->MAX_MSG_SIZE - room : TRANSFER_PIGGYBACK_ROOM;
+}
+
+/**
+ * FUNCTION NAME: reply
+ *
+ * DESCRIPTION: Answer the coordinator of request, with value for a read reply
+ */
+void MP2Node::reply(const MessageView &request, MessageType type, string_view value) {
+    MessageView message(request.transID, getMemberNode()->addr, type);
+    message.success = true;
+    message.value = value;
+    Address coordinator = request.fromAddr;
+    send(message, &coordinator);
+}
+
+/**
+ * FUNCTION NAME: queueTransfer
+ *
+ * DESCRIPTION: Add key, or its tombstone, to the keys queued for the node at to
+ */
+void MP2Node::queueTransfer(TransferQueue &queue, const Address &to, string_view key, bool deleted) {
+    TransferQueue::iterator it = std::find_if(queue.begin(), queue.end(), [&to](const pair<Address, vector<TransferKey>> &keys) {
+        return !memcmp(keys.first.addr, to.addr, sizeof(to.addr));
+    });
+    if (it == queue.end()) {
+        it = queue.emplace(queue.end(), to, vector<TransferKey>());
+    }
+    it->second.push_back(TransferKey{string(key), deleted});
+}
+
+/**
+ * FUNCTION NAME: streamKeys
+ *
+ * DESCRIPTION: Send keys, in ring order, to the node at to. They go as a range transfer:
+ * 				batches of records filling up to MAX_MSG_SIZE, TRANSFER_WINDOW of them in
+ * 				flight, the first one not acknowledged sent again after a timeout. An
+ * 				untracked stream sends every batch once and is forgotten. Without
+ * 				RANGE_TRANSFER, each key goes as its own CREATE or DELETE
+ */
+void MP2Node::streamKeys(Address to, vector <TransferKey> &keys, bool tracked) {
+    if (keys.empty()) {
+        return;
+    }
+    if (!par->RANGE_TRANSFER) {
+        std::for_each(keys.begin(), keys.end(), [this, &to](const TransferKey &key) {
+            MessageView message(-1, getMemberNode()->addr, key.deleted ? DELETE : CREATE);
+            message.key = key.key;
+            if (!key.deleted) {
+                message.value = ht->find(key.key);
+                if (message.value.empty()) {
+                    return;
+                }
+            }
+            transferStats.records++;
+            transferStats.messages++;
+            transferStats.dropped += send(message, &to) == 0;
+            transferStats.bytes += wireBuffer.size();
+        });
+        return;
+    }
+
+    RangeTransfer transfer;
+    transfer.to = to;
+    transfer.keys.swap(keys);
+    transfer.batchStart.push_back(0);
+    transfer.acked = 0;
+    transfer.next = 0;
+    transfer.started = par->getcurrtime();
+    transfer.lastProgress = transfer.started;
+    transfer.timeouts = 0;
+    int id = nextTransferId++;
+    transferStats.streams++;
+    if (!tracked) {
+        while (transfer.batchStart.back() < transfer.keys.size()) {
+            sendBatch(transfer, id, transfer.next++);
+        }
+        return;
+    }
+    fillWindow(transfers.emplace(id, std::move(transfer)).first->second, id);
+}
+
+/**
+ * FUNCTION NAME: fillWindow
+ *
+ * DESCRIPTION: Send the next batches of a stream until TRANSFER_WINDOW of them are not
+ * 				acknowledged, or the last one is out
+ */
+void MP2Node::fillWindow(RangeTransfer &transfer, int id) {
+    while (transfer.next < transfer.acked + TRANSFER_WINDOW) {
+        bool packed = transfer.batchStart.back() == transfer.keys.size();
+        if (packed && transfer.next >= transfer.batchStart.size() - 1) {
+            break;
+        }
+        sendBatch(transfer, id, transfer.next++);
+    }
+}
+
+/**
+ * FUNCTION NAME: sendBatch
+ *
+ * DESCRIPTION: Send batch seq of a stream. A new batch takes the next keys for as long as
+ * 				they fit; a batch sent again keeps its keys, so that the sequence numbers
+ * 				always cover the same records. Values are read from the store as the batch
+ * 				is packed, and keys that have left it are skipped. A value may have grown
+ * 				since its batch was first sent: keys that no longer fit are moved to the end
+ * 				of the stream, to go in a batch of their own
+ */
+void MP2Node::sendBatch(RangeTransfer &transfer, int id, uint32_t seq) {
+    size_t budget = payloadBudget(sizeof(seq));
+    // Only a batch sent before is already packed
+    bool packed = seq + 1 < transfer.batchStart.size();
+    size_t end = packed ? transfer.batchStart[seq + 1] : transfer.keys.size();
+
+    batchBuffer.clear();
+    size_t at = transfer.batchStart[seq];
+    for (; at < end; at++) {
+        TransferKey &key = transfer.keys[at];
+        string_view value;
+        if (!key.deleted) {
+            value = ht->find(key.key);
+            if (value.empty()) {
+                continue;
+            }
+        }
+        if (!batchBuffer.empty() && batchBuffer.size() + TransferBatch::recordSize(key.key, value) > budget) {
+            if (!packed) {
+                break;
+            }
+            TransferKey deferred = key;
+            transfer.keys.push_back(deferred);
+            transferStats.records--;
+            continue;
+        }
+        const KeyVersion *version = versions.find(key.key, hashFunction(key.key));
+        TransferBatch::append(batchBuffer, key.key, value, key.deleted, version ? version->stamp : par->getcurrtime());
+        transferStats.records += !packed;
+    }
+    if (!packed) {
+        transfer.batchStart.push_back(at);
+    }
+
+    char sequence[sizeof(seq)];
+    memcpy(sequence, &seq, sizeof(seq));
+    MessageView message(id, getMemberNode()->addr, TRANSFER);
+    message.key = string_view(sequence, sizeof(sequence));
+    message.value = batchBuffer;
+    message.success = transfer.batchStart[seq + 1] == transfer.keys.size();
+    transferStats.messages++;
+    transferStats.resent += packed;
+    transferStats.dropped += send(message, &transfer.to) == 0;
+    transferStats.bytes += wireBuffer.size();
+}
+
+/**
+ * FUNCTION NAME: pumpTransfers
+ *
+ * DESCRIPTION: Run once per round: send the first batch not acknowledged of the streams
+ * 				that timed out again, give up those that did TRANSFER_RETRIES times in a
+ * 				row, and send on. Receipts of streams no longer heard of are dropped
+ */
+void MP2Node::pumpTransfers() {
+    int now = par->getcurrtime();
+    map<int, RangeTransfer>::iterator it = transfers.begin();
+    while (it != transfers.end()) {
+        RangeTransfer &transfer = it->second;
+        if (now - transfer.lastProgress >= TRANSFER_TIMEOUT) {
+            if (++transfer.timeouts > TRANSFER_RETRIES) {
+                transferStats.abandoned++;
+                log->LOG(&memberNode->addr, "#STATSLOG# transfer %d to %s given up after %u batches",
+                         it->first, transfer.to.getAddress().c_str(), transfer.acked);
+                it = transfers.erase(it);
+                continue;
+            }
+            sendBatch(transfer, it->first, transfer.acked);
+            transfer.lastProgress = now;
+        }
+        fillWindow(transfer, it->first);
+        ++it;
+    }
+
+    map<pair<uint64_t, int>, TransferReceipt>::iterator receipt = receipts.begin();
+    while (receipt != receipts.end()) {
+        if (now - receipt->second.lastSeen > TRANSFER_TIMEOUT * (TRANSFER_RETRIES + 2)) {
+            receipt = receipts.erase(receipt);
+        } else {
+            ++receipt;
+        }
+    }
+}
+
+/**
+ * FUNCTION NAME: applyRecord
+ *
+ * DESCRIPTION: Apply a record of a stream as a replica transfer, and keep the round the
+ * 				key was written at rather than the round the record arrived. A record of a
+ * 				write older than ours is a late copy and is dropped
+ */
+void MP2Node::applyRecord(string_view key, string_view value, bool deleted, long stamp) {
+    size_t pos = hashFunction(key);
+    const KeyVersion *version = versions.find(key, pos);
+    if (version && version->stamp > stamp) {
+        return;
+    }
+    bool applied = deleted ? deletekey(key) :
+                   updateKeyValue(key, value, PRIMARY) || createKeyValue(key, value, PRIMARY);
+    if (applied) {
+        versions.touch(key, pos, stamp, deleted);
+    }
+}
+
+/**
+ * FUNCTION NAME: receiveBatch
+ *
+ * DESCRIPTION: Apply a batch of a stream not seen yet, as a replica transfer of each
+ * 				record, and acknowledge the batches applied up to the first gap
+ */
+void MP2Node::receiveBatch(const MessageView &message) {
+    uint64_t sender = 0;
+    memcpy(&sender, message.fromAddr.addr, sizeof(message.fromAddr.addr));
+    TransferReceipt &receipt = receipts[make_pair(sender, message.transID)];
+    receipt.lastSeen = par->getcurrtime();
+
+    uint32_t seq;
+    if (message.key.size() != sizeof(seq)) {
+        return;
+    }
+    memcpy(&seq, message.key.data(), sizeof(seq));
+    if (seq >= receipt.received && !receipt.ahead.count(seq)) {
+        string_view records = message.value;
+        string_view key;
+        string_view value;
+        bool deleted;
+        long stamp;
+        while (TransferBatch::next(records, key, value, deleted, stamp)) {
+            applyRecord(key, value, deleted, stamp);
+        }
+        receipt.ahead.insert(seq);
+        while (!receipt.ahead.empty() && *receipt.ahead.begin() == receipt.received) {
+            receipt.ahead.erase(receipt.ahead.begin());
+            receipt.received++;
+        }
+    }
+
+    char received[sizeof(receipt.received)];
+    memcpy(received, &receipt.received, sizeof(receipt.received));
+    MessageView ack(message.transID, getMemberNode()->addr, TRANSFERACK);
+    ack.key = string_view(received, sizeof(received));
+    Address to = message.fromAddr;
+    send(ack, &to);
+}
+
+/**
+ * FUNCTION NAME: transferAcked
+ *
+ * DESCRIPTION: Take the acknowledgement of a stream; the stream is done once its last
+ * 				batch is acknowledged
+ */
+void MP2Node::transferAcked(const MessageView &message) {
+    map<int, RangeTransfer>::iterator it = transfers.find(message.transID);
+    if (it == transfers.end() || memcmp(it->second.to.addr, message.fromAddr.addr, sizeof(message.fromAddr.addr))) {
+        return;
+    }
+    RangeTransfer &transfer = it->second;
+    uint32_t received = 0;
+    if (message.key.size() != sizeof(received)) {
+        return;
+    }
+    memcpy(&received, message.key.data(), sizeof(received));
+    if (received <= transfer.acked) {
+        return;
+    }
+    transfer.acked = received;
+    transfer.next = std::max(transfer.next, received);
+    transfer.lastProgress = par->getcurrtime();
+    transfer.timeouts = 0;
+    if (transfer.batchStart.back() == transfer.keys.size() && transfer.acked >= transfer.batchStart.size() - 1) {
+        transferStats.completed++;
+        transferStats.rounds += par->getcurrtime() - transfer.started;
+        transfers.erase(it);
+    }
+}
+
+/**
+ * FUNCTION NAME: streamingTo
+ *
+ * DESCRIPTION: Whether a range transfer to the node at address is under way, or keys
+ * 				offered to it are still waiting on its filters
+ */
+bool MP2Node::streamingTo(const Address &address) {
+    return std::any_of(transfers.begin(), transfers.end(), [&address](const pair<const int, RangeTransfer> &transfer) {
+        return !memcmp(transfer.second.to.addr, address.addr, sizeof(address.addr));
+    }) || std::any_of(offers.begin(), offers.end(), [&address](const pair<const int, KeyOffer> &offer) {
+        return !memcmp(offer.second.to.addr, address.addr, sizeof(address.addr));
+    });
+}
+
+/**
+ * FUNCTION NAME: buildMerkleTrees
+ *
+ * DESCRIPTION: Start a Merkle tree for every replica set of the ring we are part of, over
+ * 				the keys of that set: the arc ending at its primary token on the ring, the
+ * 				whole ring with the other placements. Then hash the keys we hold into the
+ * 				new trees. With RING_PLACEMENT, a tree whose arc did not move is kept as it
+ * 				is and only the keys of the new arcs are hashed, so a ring change costs the
+ * 				keys of the arcs it moved. With the other placements keys move between the
+ * 				trees in no ring order, and every key is hashed again. Writes update the
+ * 				trees in place
+ */
+void MP2Node::buildMerkleTrees() {
+    if (par->ANTI_ENTROPY_PERIOD <= 0) {
+        merkleTrees.clear();
+        return;
+    }
+    bool arcs = ringIndex.placement == RING_PLACEMENT;
+    map<size_t, MerkleTree> trees;
+    vector <pair<size_t, size_t>> fresh;
+    string label;
+    size_t sets = ringIndex.replicas.size();
+    for (size_t i = 0; i < sets; i++) {
+        ReplicaSet &replicas = ringIndex.replicas[i];
+        if (!holds(ring, replicas, memberNode->addr)) {
+            continue;
+        }
+        size_t owner = ring[replicas.index[0]].nodeHashCode;
+        size_t from = arcs ? ringIndex.positions[(i + sets - 1) % sets] : owner;
+        MerkleTree tree(owner, from, owner);
+        label.clear();
+        tree.label(label);
+        map<size_t, MerkleTree>::iterator old = merkleTrees.find(owner);
+        if (arcs && old != merkleTrees.end() && old->second.matches(label)) {
+            trees.emplace(owner, std::move(old->second));
+        } else {
+            trees.emplace(owner, std::move(tree));
+            fresh.emplace_back(owner, from);
+        }
+    }
+    merkleTrees.swap(trees);
+
+    if (!arcs) {
+        for (auto it = ht->hashTable.begin(); it != ht->hashTable.end(); ++it) {
+            redigest(hashFunction(it->first), MerkleTree::entryHash(it->first, it->second));
+        }
+        return;
+    }
+    vector <pair<size_t, string>> keys;
+    std::for_each(fresh.begin(), fresh.end(), [this, &keys](const pair<size_t, size_t> &arc) {
+        MerkleTree &tree = merkleTrees.at(arc.first);
+        keys.clear();
+        keyIndex.keysIn(arc.second, arc.first, keys);
+        std::for_each(keys.begin(), keys.end(), [this, &tree](const pair<size_t, string> &key) {
+            tree.toggle(key.first, MerkleTree::entryHash(key.second, ht->find(key.second)));
+        });
+    });
+}
+
+/**
+ * FUNCTION NAME: merkleTreeOf
+ *
+ * DESCRIPTION: Returns the tree holding the keys at ring position pos, NULL if we are not
+ * 				one of their replicas
+ */
+MerkleTree *MP2Node::merkleTreeOf(size_t pos) {
+    if (merkleTrees.empty()) {
+        return NULL;
+    }
+    ReplicaSet replicas = replicasOn(ringIndex, pos);
+    if (replicas.count == 0) {
+        return NULL;
+    }
+    map<size_t, MerkleTree>::iterator it = merkleTrees.find(ring[replicas.index[0]].nodeHashCode);
+    return it == merkleTrees.end() ? NULL : &it->second;
+}
+
+/**
+ * FUNCTION NAME: redigest
+ *
+ * DESCRIPTION: Apply change, the xor of the entry hashes a write removed and added, to the
+ * 				tree of ring position pos
+ */
+void MP2Node::redigest(size_t pos, uint64_t change) {
+    MerkleTree *tree = merkleTreeOf(pos);
+    if (tree) {
+        tree->toggle(pos, change);
+    }
+}
+
+/**
+ * FUNCTION NAME: hashingEntries
+ *
+ * DESCRIPTION: Whether writes have to hash their entries, for the Merkle trees or the filters
+ */
+bool MP2Node::hashingEntries() {
+    return !merkleTrees.empty() || par->STABILIZE_FILTER;
+}
+
+/**
+ * FUNCTION NAME: entryChanged
+ *
+ * DESCRIPTION: Take a write at ring position pos into the Merkle trees and the filters:
+ * 				removed is the hash of the entry it replaced, added that of the entry it
+ * 				stored, 0 for none
+ */
+void MP2Node::entryChanged(size_t pos, uint64_t removed, uint64_t added) {
+    redigest(pos, removed ^ added);
+    if (!par->STABILIZE_FILTER) {
+        return;
+    }
+    if (removed) {
+        keyFilter.remove(pos, removed);
+    }
+    if (added && keyFilter.add(pos, added)) {
+        growFilter(pos);
+    }
+}
+
+/**
+ * FUNCTION NAME: growFilter
+ *
+ * DESCRIPTION: Rebuild the filter of the ring range of pos, which its keys outgrew, from
+ * 				the entries we hold in the range. The filter doubles at least, so the
+ * 				rebuilds of a range cost about twice its keys in all
+ */
+void MP2Node::growFilter(size_t pos) {
+    size_t range = KeyVersions::rangeOf(pos);
+    size_t lo;
+    size_t hi;
+    KeyFilter::rangeBounds(range, lo, hi);
+    vector<pair<size_t, string>> keys;
+    keyIndex.keysIn(lo, hi, keys);
+    vector<uint64_t> hashes;
+    hashes.reserve(keys.size());
+    std::for_each(keys.begin(), keys.end(), [this, &hashes](const pair<size_t, string> &key) {
+        hashes.push_back(MerkleTree::entryHash(key.second, ht->find(key.second)));
+    });
+    keyFilter.rebuild(range, hashes);
+}
+
+/**
+ * FUNCTION NAME: stateOf
+ *
+ * DESCRIPTION: Returns what we hold for key, at ring position pos
+ */
+KeyState MP2Node::stateOf(string_view key, size_t pos) {
+    KeyState state;
+    const KeyVersion *version = versions.find(key, pos);
+    string_view value = ht->find(key);
+    state.stamp = version ? version->stamp : -1;
+    state.deleted = value.empty();
+    state.hash = state.deleted ? 0 : MerkleTree::entryHash(key, value);
+    return state;
+}
+
+/**
+ * FUNCTION NAME: leafKeys
+ *
+ * DESCRIPTION: The keys we hold in leaf node of tree, with their ring positions. With the
+ * 				placements other than the ring, the arc of a leaf also holds keys of other
+ * 				trees, which are left out
+ */
+void MP2Node::leafKeys(MerkleTree &tree, uint32_t node, vector<pair<size_t, string>> &keys) {
+    size_t lo;
+    size_t hi;
+    if (!tree.leafRange(node, lo, hi)) {
+        return;
+    }
+    keyIndex.keysIn(lo, hi, keys);
+    keys.erase(std::remove_if(keys.begin(), keys.end(), [this, &tree](const pair<size_t, string> &key) {
+        return merkleTreeOf(key.first) != &tree;
+    }), keys.end());
+}
+
+/**
+ * FUNCTION NAME: sendAntiEntropy
+ *
+ * DESCRIPTION: Send a message of the anti-entropy protocol and count it
+ */
+void MP2Node::sendAntiEntropy(MessageView &message, Address to) {
+    send(message, &to);
+    antiEntropyStats.messages++;
+    antiEntropyStats.bytes += wireBuffer.size();
+}
+
+/**
+ * FUNCTION NAME: startAntiEntropy
+ *
+ * DESCRIPTION: Run every ANTI_ENTROPY_PERIOD rounds: send the root hash of each tree we
+ * 				are the primary of to the other replicas of its keys. Replicas we are
+ * 				streaming keys to are skipped until the stream is done, as their trees
+ * 				differ from ours until then
+ */
+void MP2Node::startAntiEntropy() {
+    if (merkleTrees.empty() || catchUpPending) {
+        return;
+    }
+    string label;
+    string root;
+    for (size_t i = 0; i < ringIndex.replicas.size(); i++) {
+        ReplicaSet &replicas = ringIndex.replicas[i];
+        Node &primary = ring[replicas.index[0]];
+        if (memcmp(primary.nodeAddress.addr, memberNode->addr.addr, sizeof(memberNode->addr.addr))) {
+            continue;
+        }
+        map<size_t, MerkleTree>::iterator tree = merkleTrees.find(primary.nodeHashCode);
+        if (tree == merkleTrees.end()) {
+            continue;
+        }
+        label.clear();
+        tree->second.label(label);
+        root.clear();
+        MerkleTree::appendNode(root, 0, tree->second.hashOf(0));
+        for (size_t j = 1; j < replicas.count; j++) {
+            Address peer = ring[replicas.index[j]].nodeAddress;
+            if (streamingTo(peer)) {
+                continue;
+            }
+            MessageView message(-1, memberNode->addr, MERKLE);
+            message.key = label;
+            message.value = root;
+            sendAntiEntropy(message, peer);
+            antiEntropyStats.exchanges++;
+        }
+    }
+}
+
+/**
+ * FUNCTION NAME: compareNodes
+ *
+ * DESCRIPTION: Compare the nodes of a replica's tree with those of ours. For the inner
+ * 				nodes that differ, send back the hashes of our children for the replica to
+ * 				compare in turn; for the leaves that differ, send our keys in them. Only
+ * 				the subtrees that differ are walked down, so the messages grow with the
+ * 				divergence and not with the keys. Nodes past the budget of a message wait
+ * 				for the next exchange
+ */
+void MP2Node::compareNodes(const MessageView &message) {
+    map<size_t, MerkleTree>::iterator it = merkleTrees.find(MerkleTree::ownerOf(message.key));
+    if (it == merkleTrees.end() || !it->second.matches(message.key)) {
+        return;
+    }
+    MerkleTree &tree = it->second;
+    size_t budget = payloadBudget(MERKLE_LABEL_SIZE);
+    Address peer = message.fromAddr;
+    string children;
+    string_view nodes = message.value;
+    uint32_t node;
+    uint64_t hash;
+    while (MerkleTree::nextNode(nodes, node, hash)) {
+        if (tree.hashOf(node) == hash) {
+            continue;
+        }
+        antiEntropyStats.diverged += node == 0;
+        if (!MerkleTree::isLeaf(node)) {
+            if (children.size() + 2 * MERKLE_NODE_SIZE <= budget) {
+                MerkleTree::appendNode(children, 2 * node + 1, tree.hashOf(2 * node + 1));
+                MerkleTree::appendNode(children, 2 * node + 2, tree.hashOf(2 * node + 2));
+            }
+            continue;
+        }
+
+        vector<pair<size_t, string>> keys;
+        leafKeys(tree, node, keys);
+        string entries;
+        for (size_t i = 0; i < keys.size() && entries.size() + MerkleTree::entrySize(keys[i].second) <= budget; i++) {
+            MerkleTree::appendEntry(entries, keys[i].second, stateOf(keys[i].second, keys[i].first));
+        }
+        MessageView request((int) (node - (MERKLE_LEAVES - 1)), memberNode->addr, MERKLEKEYS);
+        request.key = message.key;
+        request.value = entries;
+        sendAntiEntropy(request, peer);
+        antiEntropyStats.leaves++;
+    }
+    if (!children.empty()) {
+        MessageView reply(-1, memberNode->addr, MERKLE);
+        reply.key = message.key;
+        reply.value = children;
+        sendAntiEntropy(reply, peer);
+    }
+}
+
+/**
+ * FUNCTION NAME: answerLeaf
+ *
+ * DESCRIPTION: Answer the keys a replica sent from a leaf that differs: what we hold for
+ * 				each of them, tombstones and missing keys included, then our other keys in
+ * 				that leaf. The replica settles every key knowing both sides
+ */
+void MP2Node::answerLeaf(const MessageView &message) {
+    map<size_t, MerkleTree>::iterator it = merkleTrees.find(MerkleTree::ownerOf(message.key));
+    if (it == merkleTrees.end() || !it->second.matches(message.key) || message.transID < 0 ||
+        message.transID >= MERKLE_LEAVES) {
+        return;
+    }
+    size_t budget = payloadBudget(MERKLE_LABEL_SIZE);
+    string answer;
+    vector<string_view> listed;
+    string_view entries = message.value;
+    string_view key;
+    KeyState state;
+    // The states of the listed keys take what the request took, so they always fit
+    while (MerkleTree::nextEntry(entries, key, state)) {
+        listed.push_back(key);
+        MerkleTree::appendEntry(answer, key, stateOf(key, hashFunction(key)));
+    }
+    std::sort(listed.begin(), listed.end());
+
+    vector<pair<size_t, string>> keys;
+    leafKeys(it->second, (uint32_t) message.transID + MERKLE_LEAVES - 1, keys);
+    for (size_t i = 0; i < keys.size() && answer.size() + MerkleTree::entrySize(keys[i].second) <= budget; i++) {
+        if (!std::binary_search(listed.begin(), listed.end(), string_view(keys[i].second))) {
+            MerkleTree::appendEntry(answer, keys[i].second, stateOf(keys[i].second, keys[i].first));
+        }
+    }
+
+    MessageView reply(message.transID, memberNode->addr, MERKLEKEYS);
+    reply.key = message.key;
+    reply.value = answer;
+    reply.success = true;
+    sendAntiEntropy(reply, message.fromAddr);
+}
+
+/**
+ * FUNCTION NAME: repairLeaf
+ *
+ * DESCRIPTION: Settle the keys of a leaf a replica answered with: the later write wins, a
+ * 				delete winning a tie, then the larger hash. Keys where ours wins are
+ * 				streamed to the replica, those where its copy wins are asked of it. Keys
+ * 				held by neither side are left alone
+ */
+void MP2Node::repairLeaf(const MessageView &message) {
+    map<size_t, MerkleTree>::iterator it = merkleTrees.find(MerkleTree::ownerOf(message.key));
+    if (it == merkleTrees.end() || !it->second.matches(message.key)) {
+        return;
+    }
+    vector<TransferKey> push;
+    string pull;
+    string_view entries = message.value;
+    string_view key;
+    KeyState theirs;
+    while (MerkleTree::nextEntry(entries, key, theirs)) {
+        KeyState ours = stateOf(key, hashFunction(key));
+        // Neither side holds it, or both hold the same value
+        bool same = ours.deleted ? theirs.deleted : !theirs.deleted && ours.hash == theirs.hash;
+        if (same) {
+            continue;
+        }
+        bool oursWins = ours.stamp != theirs.stamp ? ours.stamp > theirs.stamp :
+                        ours.deleted != theirs.deleted ? ours.deleted : ours.hash > theirs.hash;
+        if (oursWins) {
+            push.push_back(TransferKey{string(key), ours.deleted});
+        } else {
+            TransferBatch::append(pull, key, string_view(), false, -1);
+            antiEntropyStats.pulled++;
+        }
+    }
+    antiEntropyStats.pushed += push.size();
+    streamKeys(message.fromAddr, push, true);
+    if (!pull.empty()) {
+        MessageView request(-1, memberNode->addr, MERKLEPULL);
+        request.key = message.key;
+        request.value = pull;
+        sendAntiEntropy(request, message.fromAddr);
+    }
+}
+
+/**
+ * FUNCTION NAME: answerPull
+ *
+ * DESCRIPTION: Stream the keys a replica asked for after comparing a leaf, or their
+ * 				tombstones
+ */
+void MP2Node::answerPull(const MessageView &message) {
+    vector<TransferKey> keys;
+    string_view records = message.value;
+    string_view key;
+    string_view value;
+    bool deleted;
+    long stamp;
+    while (TransferBatch::next(records, key, value, deleted, stamp)) {
+        keys.push_back(TransferKey{string(key), ht->find(key).empty()});
+    }
+    streamKeys(message.fromAddr, keys, true);
+}
+
+/**
+ * FUNCTION NAME: sendFilterMessage
+ *
+ * DESCRIPTION: Send a message of the filter protocol and count it
+ */
+void MP2Node::sendFilterMessage(MessageView &message, Address to) {
+    send(message, &to);
+    filterStats.messages++;
+    filterStats.bytes += wireBuffer.size();
+}
+
+/**
+ * FUNCTION NAME: offerKeys
+ *
+ * DESCRIPTION: Offer keys the stabilization protocol sends a new replica: ask it for the
+ * 				filters of the ring ranges they fall in, and hold them until it answers.
+ * 				The keys of ranges whose records take fewer bytes than our filter of the
+ * 				range, which the replica's should be about the size of, and the tombstones,
+ * 				are streamed at once
+ */
+void MP2Node::offerKeys(Address to, vector <TransferKey> &keys) {
+    size_t bytes[VERSION_RANGES] = {};
+    std::for_each(keys.begin(), keys.end(), [this, &bytes](const TransferKey &key) {
+        bytes[KeyVersions::rangeOf(hashFunction(key.key))] += TransferBatch::recordSize(key.key, ht->find(key.key));
+    });
+
+    KeyOffer offer;
+    offer.to = to;
+    offer.ranges = 0;
+    offer.perChunk = 0;
+    offer.chunksPending = 0;
+    offer.lastProgress = par->getcurrtime();
+    vector<TransferKey> direct;
+    std::for_each(keys.begin(), keys.end(), [&](TransferKey &key) {
+        size_t range = KeyVersions::rangeOf(hashFunction(key.key));
+        if (key.deleted || bytes[range] <= keyFilter.bitsSize(range)) {
+            direct.push_back(std::move(key));
+        } else {
+            offer.ranges |= (uint64_t) 1 << range;
+            offer.keys.push_back(std::move(key));
+        }
+    });
+    filterStats.offered += keys.size();
+    streamKeys(to, direct, true);
+    if (offer.keys.empty()) {
+        return;
+    }
+
+    offer.verdicts.assign(offer.keys.size(), OFFER_UNDECIDED);
+    int id = nextTransferId++;
+    MessageView request(id, memberNode->addr, FILTERREQ);
+    request.key = string_view((const char *) &offer.ranges, sizeof(offer.ranges));
+    sendFilterMessage(request, to);
+    offers.emplace(id, std::move(offer));
+}
+
+/**
+ * FUNCTION NAME: sendFilters
+ *
+ * DESCRIPTION: Answer a key offer with the filters of the ranges it asks for, as many to
+ * 				a message as fit
+ */
+void MP2Node::sendFilters(const MessageView &message) {
+    uint64_t ranges;
+    if (message.key.size() != sizeof(ranges)) {
+        return;
+    }
+    memcpy(&ranges, message.key.data(), sizeof(ranges));
+    size_t budget = payloadBudget(sizeof(ranges));
+    string bits;
+    uint64_t included = 0;
+    for (size_t range = 0; range < VERSION_RANGES; range++) {
+        if (!(ranges & ((uint64_t) 1 << range))) {
+            continue;
+        }
+        keyFilter.appendBits(range, bits);
+        included |= (uint64_t) 1 << range;
+        uint64_t later = ranges & ~(((uint64_t) 2 << range) - 1);
+        if (later == 0 || bits.size() + keyFilter.bitsSize(__builtin_ctzll(later)) > budget) {
+            MessageView reply(message.transID, memberNode->addr, FILTERREP);
+            reply.key = string_view((const char *) &included, sizeof(included));
+            reply.value = bits;
+            sendFilterMessage(reply, message.fromAddr);
+            bits.clear();
+            included = 0;
+        }
+    }
+}
+
+/**
+ * FUNCTION NAME: filtersArrived
+ *
+ * DESCRIPTION: Sort the offered keys of the ranges whose filters a replica sent: those the
+ * 				filter surely lacks are to be sent, the others to be confirmed. Once every
+ * 				filter is in, the offer is settled
+ */
+void MP2Node::filtersArrived(const MessageView &message) {
+    map<int, KeyOffer>::iterator it = offers.find(message.transID);
+    uint64_t included;
+    if (it == offers.end() || memcmp(it->second.to.addr, message.fromAddr.addr, sizeof(message.fromAddr.addr)) ||
+        message.key.size() != sizeof(included)) {
+        return;
+    }
+    memcpy(&included, message.key.data(), sizeof(included));
+    // The filters come in range order, each sized for the keys the replica has in its range
+    string_view filters = message.value;
+    string_view bits[VERSION_RANGES];
+    for (size_t range = 0; range < VERSION_RANGES; range++) {
+        if ((included & ((uint64_t) 1 << range)) && !KeyFilter::nextBits(filters, bits[range])) {
+            return;
+        }
+    }
+    if (!filters.empty()) {
+        return;
+    }
+    KeyOffer &offer = it->second;
+    for (size_t i = 0; i < offer.keys.size(); i++) {
+        size_t range = KeyVersions::rangeOf(hashFunction(offer.keys[i].key));
+        uint64_t bit = (uint64_t) 1 << range;
+        if (offer.verdicts[i] != OFFER_UNDECIDED || !(included & offer.ranges & bit)) {
+            continue;
+        }
+        string_view value = ht->find(offer.keys[i].key);
+        bool positive = !value.empty() &&
+                        KeyFilter::mayContain(bits[range], MerkleTree::entryHash(offer.keys[i].key, value));
+        offer.verdicts[i] = positive ? OFFER_CONFIRM : OFFER_SEND;
+    }
+    offer.ranges &= ~included;
+    offer.lastProgress = par->getcurrtime();
+    if (offer.ranges == 0) {
+        confirmKeys(it);
+    }
+}
+
+/**
+ * FUNCTION NAME: confirmKeys
+ *
+ * DESCRIPTION: Settle an offer whose filters are all in: stream the keys to send, and ask
+ * 				the replica to confirm the others by the digests of their entries, a chunk
+ * 				of them to a message. A digest takes a fraction of the record it stands for
+ */
+void MP2Node::confirmKeys(map<int, KeyOffer>::iterator it) {
+    KeyOffer &offer = it->second;
+    vector<TransferKey> send;
+    for (size_t i = 0; i < offer.keys.size(); i++) {
+        if (offer.verdicts[i] == OFFER_SEND) {
+            send.push_back(offer.keys[i]);
+        } else if (offer.verdicts[i] == OFFER_CONFIRM) {
+            offer.confirming.push_back(i);
+        }
+    }
+    streamKeys(offer.to, send, true);
+
+    size_t keySize = sizeof(uint64_t) + sizeof(uint32_t);
+    offer.perChunk = payloadBudget(keySize) / FILTER_DIGEST_SIZE;
+    offer.chunksPending = (offer.confirming.size() + offer.perChunk - 1) / offer.perChunk;
+    filterStats.confirmed += offer.confirming.size();
+    string key;
+    string digests;
+    for (uint32_t chunk = 0; chunk < offer.chunksPending; chunk++) {
+        uint64_t ranges = 0;
+        digests.clear();
+        size_t end = std::min((chunk + 1) * offer.perChunk, offer.confirming.size());
+        for (size_t j = chunk * offer.perChunk; j < end; j++) {
+            TransferKey &confirm = offer.keys[offer.confirming[j]];
+            ranges |= (uint64_t) 1 << KeyVersions::rangeOf(hashFunction(confirm.key));
+            uint32_t digest = KeyFilter::digestOf(MerkleTree::entryHash(confirm.key, ht->find(confirm.key)));
+            digests.append((const char *) &digest, sizeof(digest));
+        }
+        key.assign((const char *) &ranges, sizeof(ranges));
+        key.append((const char *) &chunk, sizeof(chunk));
+        MessageView request(it->first, memberNode->addr, CONFIRMREQ);
+        request.key = key;
+        request.value = digests;
+        sendFilterMessage(request, offer.to);
+    }
+    if (offer.chunksPending == 0) {
+        offers.erase(it);
+    }
+}
+
+/**
+ * FUNCTION NAME: answerConfirm
+ *
+ * DESCRIPTION: Answer a chunk of digests with the positions of those we hold no entry for,
+ * 				looking only at the ranges the chunk falls in
+ */
+void MP2Node::answerConfirm(const MessageView &message) {
+    uint64_t ranges;
+    if (message.key.size() != sizeof(ranges) + sizeof(uint32_t)) {
+        return;
+    }
+    memcpy(&ranges, message.key.data(), sizeof(ranges));
+    unordered_set<uint32_t> held;
+    vector<pair<size_t, string>> keys;
+    for (size_t range = 0; range < VERSION_RANGES; range++) {
+        if (ranges & ((uint64_t) 1 << range)) {
+            size_t lo;
+            size_t hi;
+            KeyFilter::rangeBounds(range, lo, hi);
+            keyIndex.keysIn(lo, hi, keys);
+        }
+    }
+    std::for_each(keys.begin(), keys.end(), [this, &held](const pair<size_t, string> &key) {
+        held.insert(KeyFilter::digestOf(MerkleTree::entryHash(key.second, ht->find(key.second))));
+    });
+
+    string missing;
+    uint32_t count = (uint32_t) (message.value.size() / FILTER_DIGEST_SIZE);
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t digest;
+        memcpy(&digest, message.value.data() + i * FILTER_DIGEST_SIZE, sizeof(digest));
+        if (!held.count(digest)) {
+            missing.append((const char *) &i, sizeof(i));
+        }
+    }
+    MessageView reply(message.transID, memberNode->addr, CONFIRMREP);
+    reply.key = message.key.substr(sizeof(ranges));
+    reply.value = missing;
+    sendFilterMessage(reply, message.fromAddr);
+}
+
+/**
+ * FUNCTION NAME: confirmArrived
+ *
+ * DESCRIPTION: Take a replica's answer to a chunk of digests: stream the keys it lacks,
+ * 				leave out the others. The offer is done once every chunk is answered
+ */
+void MP2Node::confirmArrived(const MessageView &message) {
+    map<int, KeyOffer>::iterator it = offers.find(message.transID);
+    uint32_t chunk;
+    if (it == offers.end() || memcmp(it->second.to.addr, message.fromAddr.addr, sizeof(message.fromAddr.addr)) ||
+        message.key.size() != sizeof(chunk)) {
+        return;
+    }
+    memcpy(&chunk, message.key.data(), sizeof(chunk));
+    KeyOffer &offer = it->second;
+    size_t first = chunk * offer.perChunk;
+    // A chunk answered before has no key left to confirm
+    if (first >= offer.confirming.size() || offer.verdicts[offer.confirming[first]] != OFFER_CONFIRM) {
+        return;
+    }
+    size_t end = std::min(first + offer.perChunk, offer.confirming.size());
+    for (size_t j = first; j < end; j++) {
+        offer.verdicts[offer.confirming[j]] = OFFER_SKIP;
+    }
+    string_view missing = message.value;
+    while (missing.size() >= sizeof(uint32_t)) {
+        uint32_t i;
+        memcpy(&i, missing.data(), sizeof(i));
+        missing.remove_prefix(sizeof(i));
+        if (first + i < end) {
+            offer.verdicts[offer.confirming[first + i]] = OFFER_SEND;
+        }
+    }
+
+    vector<TransferKey> send;
+    for (size_t j = first; j < end; j++) {
+        TransferKey &key = offer.keys[offer.confirming[j]];
+        if (offer.verdicts[offer.confirming[j]] == OFFER_SEND) {
+            send.push_back(key);
+        } else {
+            filterStats.skipped++;
+            filterStats.skippedBytes += TransferBatch::recordSize(key.key, ht->find(key.key));
+        }
+    }
+    streamKeys(offer.to, send, true);
+    offer.lastProgress = par->getcurrtime();
+    if (--offer.chunksPending == 0) {
+        offers.erase(it);
+    }
+}
+
+/**
+ * FUNCTION NAME: expireOffers
+ *
+ * DESCRIPTION: Run once per round: stream in full the keys of the offers whose replica
+ * 				has not answered for TRANSFER_TIMEOUT rounds, as a lost filter or digest
+ * 				must not cost a replica
+ */
+void MP2Node::expireOffers() {
+    int now = par->getcurrtime();
+    map<int, KeyOffer>::iterator it = offers.begin();
+    while (it != offers.end()) {
+        KeyOffer &offer = it->second;
+        if (now - offer.lastProgress < TRANSFER_TIMEOUT) {
+            ++it;
+            continue;
+        }
+        vector<TransferKey> send;
+        for (size_t i = 0; i < offer.keys.size(); i++) {
+            if (offer.verdicts[i] == OFFER_UNDECIDED || offer.verdicts[i] == OFFER_CONFIRM) {
+                send.push_back(offer.keys[i]);
+            }
+        }
+        filterStats.expired++;
+        streamKeys(offer.to, send, true);
+        it = offers.erase(it);
+    }
+}
+
+/**
+ * FUNCTION NAME: setPiggyback
+ *
+ * DESCRIPTION: Let the membership protocol ride on the messages of this node
+ */
+void MP2Node::setPiggyback(MembershipPiggyback *piggyback) {
+    this->piggyback = piggyback;
+}
+
+/**
+ * FUNCTION NAME: addStoreUsage
+ *
+ * DESCRIPTION: Add the memory taken by the hash table of this node to usage
+ */
+void MP2Node::addStoreUsage(TableUsage &usage) {
+    ht->addUsage(usage);
+}
+
+/**
+ * FUNCTION NAME: getRequestsServed
+ *
+ * DESCRIPTION: Client requests this node served as a replica
+ */
+long MP2Node::getRequestsServed() {
+    return requestsServed;
+}
+
+/**
+ * FUNCTION NAME: getKeyCount
+ *
+ * DESCRIPTION: Keys held by this node
+ */
+unsigned long MP2Node::getKeyCount() {
+    return ht->currentSize();
+}
+
+/**
+ * FUNCTION NAME: ringShare
+ *
+ * DESCRIPTION: Share of the ring this node is the first replica of: the arcs ending at
+ * 				its tokens, on its own view of the ring. With the other placements, its
+ * 				share of the Maglev table, or one bucket of jump hashing
+ */
+double MP2Node::ringShare() {
+    if (ring.empty()) {
+        return 0;
+    }
+    if (ringIndex.placement != RING_PLACEMENT) {
+        size_t m = 0;
+        while (m < ringIndex.members.size() &&
+               memcmp(ring[ringIndex.members[m]].nodeAddress.addr, memberNode->addr.addr, sizeof(memberNode->addr.addr))) {
+            m++;
+        }
+        if (m == ringIndex.members.size()) {
+            return 0;
+        }
+        if (ringIndex.placement == JUMP_PLACEMENT) {
+            return 1.0 / ringIndex.members.size();
+        }
+        return (double) std::count(ringIndex.table.begin(), ringIndex.table.end(), (uint32_t) m) / ringIndex.table.size();
+    }
+    double share = 0;
+    for (size_t i = 0; i < ring.size(); i++) {
+        if (!memcmp(ring[i].nodeAddress.addr, memberNode->addr.addr, sizeof(memberNode->addr.addr))) {
+            size_t arc = ring[i].nodeHashCode - ring[(i + ring.size() - 1) % ring.size()].nodeHashCode;
+            share += ring.size() == 1 ? 1.0 : std::ldexp((double) arc, -64);
+        }
+    }
+    return share;
+}
+
+/**
+ * FUNCTION NAME: addPlacementCost
+ *
+ * DESCRIPTION: Add the ring index rebuilds of this node, and the keys they moved, to cost
+ */
+void MP2Node::addPlacementCost(PlacementCost &cost) {
+    cost.builds += placementCost.builds;
+    cost.buildMicros += placementCost.buildMicros;
+    cost.changes += placementCost.changes;
+    cost.movedReplicas += placementCost.movedReplicas;
+    cost.movedOwners += placementCost.movedOwners;
+}
+
+/**
+ * FUNCTION NAME: addTransferStats
+ *
+ * DESCRIPTION: Add the replica transfers this node sent to stats
+ */
+void MP2Node::addTransferStats(TransferStats &stats) {
+    stats.records += transferStats.records;
+    stats.messages += transferStats.messages;
+    stats.resent += transferStats.resent;
+    stats.dropped += transferStats.dropped;
+    stats.bytes += transferStats.bytes;
+    stats.streams += transferStats.streams;
+    stats.completed += transferStats.completed;
+    stats.abandoned += transferStats.abandoned;
+    stats.rounds += transferStats.rounds;
+}
+
+/**
+ * FUNCTION NAME: addAntiEntropyStats
+ *
+ * DESCRIPTION: Add the Merkle tree exchanges of this node to stats
+ */
+void MP2Node::addAntiEntropyStats(AntiEntropyStats &stats) {
+    stats.exchanges += antiEntropyStats.exchanges;
+    stats.diverged += antiEntropyStats.diverged;
+    stats.messages += antiEntropyStats.messages;
+    stats.bytes += antiEntropyStats.bytes;
+    stats.leaves += antiEntropyStats.leaves;
+    stats.pushed += antiEntropyStats.pushed;
+    stats.pulled += antiEntropyStats.pulled;
+}
+
+/**
+ * FUNCTION NAME: addFilterStats
+ *
+ * DESCRIPTION: Add the keys this node offered against the filters of replicas to stats
+ */
+void MP2Node::addFilterStats(FilterStats &stats) {
+    stats.offered += filterStats.offered;
+    stats.skipped += filterStats.skipped;
+    stats.skippedBytes += filterStats.skippedBytes;
+    stats.confirmed += filterStats.confirmed;
+    stats.messages += filterStats.messages;
+    stats.bytes += filterStats.bytes;
+    stats.expired += filterStats.expired;
+}
+
+/**
+ * FUNCTION NAME: rebalancing
+ *
+ * DESCRIPTION: Whether this node ran a slice of rebalancing this round
+ */
+bool MP2Node::rebalancing() {
+    return lastSlice == par->getcurrtime();
+}
+
+/**
+ * FUNCTION NAME: addRebalanceStats
+ *
+ * DESCRIPTION: Add the rebalancing tasks of this node to stats
+ */
+void MP2Node::addRebalanceStats(RebalanceStats &stats) {
+    stats.tasks += rebalanceStats.tasks;
+    stats.restarts += rebalanceStats.restarts;
+    stats.finished += rebalanceStats.finished;
+    stats.rounds += rebalanceStats.rounds;
+    stats.slices += rebalanceStats.slices;
+    stats.scanned += rebalanceStats.scanned;
+    stats.queued += rebalanceStats.queued;
+    stats.bytes += rebalanceStats.bytes;
+    stats.sliceMicros += rebalanceStats.sliceMicros;
+    stats.maxSliceMicros = std::max(stats.maxSliceMicros, rebalanceStats.maxSliceMicros);
+}
+
+/**
+ * FUNCTION NAME: preload
+ *
+ * DESCRIPTION: Store key on this node directly, as one of its replicas, to load the store
+ * 				before a test
+ */
+void MP2Node::preload(string_view key, string_view value) {
+    createKeyValue(key, value, PRIMARY);
+}
+
+/**
+ * FUNCTION NAME: getOpLatencies
+ *
+ * DESCRIPTION: Round each transaction coordinated here that reached quorum started at,
+ * 				and the rounds it took
+ */
+const vector<pair<int, int>> &MP2Node::getOpLatencies() {
+    return opLatencies;
+}
+
+/**
+ * FUNCTION NAME: handleMessage
+ *
+ * DESCRIPTION: Serve a message in place: keys and values are views into the receive
+ * 				buffer and are only copied when stored in the hash table
+ */
+void MP2Node::handleMessage(const MessageView &message) {
+    if (message.transID != -1 && message.type <= DELETE) {
+        requestsServed++;
+    }
+    switch (message.type) {
+        case CREATE:
+            if(message.transID == -1) {
+                // Replica transfer: the sender's copy is at least as recent as ours
+                if (!updateKeyValue(message.key, message.value, PRIMARY)) {
+                    createKeyValue(message.key, message.value, PRIMARY);
+                }
+            } else {
+                if(createKeyValue(message.key, message.value, PRIMARY)) {
+                    log->logCreateSuccess(&(getMemberNode()->addr), false, message.transID, message.key, message.value);
+                    reply(message, REPLY, string_view());
+                } else {
+                    log->logCreateFail(&(getMemberNode()->addr), false, message.transID, message.key, message.value);
+                }
+            }
+            break;
+
+        case READ:
+            {
+                string_view ret = readKey(message.key);
+                if(!ret.empty()) {
+                    log->logReadSuccess(&(getMemberNode()->addr), false, message.transID, message.key, ret);
+                    reply(message, READREPLY, ret);
+                } else {
+                    log->logReadFail(&(getMemberNode()->addr), false, message.transID, message.key);
+                }
+            }
+            break;
+
+        case UPDATE:
             if(updateKeyValue(message.key, message.value, PRIMARY)) {
                 log->logUpdateSuccess(&(getMemberNode()->addr), false, message.transID, message.key, message.value);
-                Message reply(message.transID, getMemberNode()->addr, REPLY, message.key);
-                dispatchMessage(reply, &(message.fromAddr));
+                reply(message, REPLY, string_view());
             } else {
                 log->logUpdateFail(&(getMemberNode()->addr), false, message.transID, message.key, message.value);
             }
@@ -419,10 +2253,12 @@ void MP2Node::handleMessage(Message message) {
             
 
         case DELETE:
-            if(deletekey(message.key)) {
+            if (message.transID == -1) {
+                // Replica transfer of a delete
+                deletekey(message.key);
+            } else if(deletekey(message.key)) {
                 log->logDeleteSuccess(&(getMemberNode()->addr), false, message.transID, message.key);
-                Message reply(message.transID, getMemberNode()->addr, REPLY, true);
-                dispatchMessage(reply, &(message.fromAddr));
+                reply(message, REPLY, string_view());
             } else {
                 log->logDeleteFail(&(getMemberNode()->addr), false, message.transID, message.key);
             }
@@ -433,40 +2269,113 @@ void MP2Node::handleMessage(Message message) {
         case READREPLY:
             recordTransactionReply(message);
             break;
+
+        case CATCHUP:
+            {
+                int64_t since = -1;
+                if (message.key.size() == sizeof(since)) {
+                    memcpy(&since, message.key.data(), sizeof(since));
+                }
+                answerCatchUp(message.fromAddr, (long) since);
+            }
+            break;
+
+        case TRANSFER:
+            receiveBatch(message);
+            break;
+
+        case TRANSFERACK:
+            transferAcked(message);
+            break;
+
+        case MERKLE:
+            compareNodes(message);
+            break;
+
+        case MERKLEKEYS:
+            if (message.success) {
+                repairLeaf(message);
+            } else {
+                answerLeaf(message);
+            }
+            break;
+
+        case MERKLEPULL:
+            answerPull(message);
+            break;
+
+        case FILTERREQ:
+            sendFilters(message);
+            break;
+
+        case FILTERREP:
+            filtersArrived(message);
+            break;
+
+        case CONFIRMREQ:
+            answerConfirm(message);
+            break;
+
+        case CONFIRMREP:
+            confirmArrived(message);
+            break;
     }
 }
 
+/**
+ * FUNCTION NAME: recordTransaction
+ *
+ * DESCRIPTION: Wait for the replies to a request sent as coordinator, failing it if
+ * 				QUORUM of them are not in within RTT rounds
+ */
 void MP2Node::recordTransaction (Message message) {
     Transaction transaction;
     transaction.timestamp = par->getcurrtime();
-    transaction.request = message.toString();
+    transaction.request = message.encode();
 
-    transactions.emplace(message.transID, transaction);
+    transactions.insert(message.transID, std::move(transaction));
+    transactionTimers.schedule(message.transID, par->getcurrtime() + RTT + 1);
 }
 
-void MP2Node::recordTransactionReply (Message message) {
-    map<int, Transaction>::iterator search;
-
-    search = transactions.find(message.transID);
-    if (search != transactions.end())
-        search->second.responses.push_back(message.toString());
+/**
+ * FUNCTION NAME: recordTransactionReply
+ *
+ * DESCRIPTION: Take the reply of a replica to a transaction, and complete the transaction
+ * 				as soon as it has QUORUM of them. Replies coming after are dropped
+ */
+void MP2Node::recordTransactionReply (const MessageView &message) {
+    Transaction *transaction = transactions.find(message.transID);
+    if (transaction == NULL) {
+        return;
+    }
+    transaction->responses.emplace_back(message.value);
+    if (transaction->responses.size() >= QUORUM) {
+        logSuccess(*transaction);
+        opLatencies.emplace_back(transaction->timestamp, par->getcurrtime() - transaction->timestamp);
+        transactions.erase(message.transID);
+    }
 }
 
+/**
+ * FUNCTION NAME: checkForQuorum
+ *
+ * DESCRIPTION: Run once per round: fail the transactions whose timer is due. Those that
+ * 				reached quorum are gone already, their timers are ignored
+ */
 void MP2Node::checkForQuorum() {
-    std::for_each(transactions.begin(), transactions.end(), [this](pair<int, Transaction> mPair) {
-        if(mPair.second.responses.size() >= QUORUM) {
-            logSuccess(mPair.second);
-            removeTrnsaction(mPair.first);
-        }
-        if(par->getcurrtime() > mPair.second.timestamp + RTT) {
-            logFailure(mPair.second);
-            removeTrnsaction(mPair.first);
+    vector <Timer> due;
+    transactionTimers.advance(par->getcurrtime(), due);
+    std::for_each(due.begin(), due.end(), [this](const Timer &timer) {
+        Transaction *transaction = transactions.find((int) timer.key);
+        if (transaction != NULL) {
+            logFailure(*transaction);
+            transactions.erase((int) timer.key);
         }
     });
 }
 
-void MP2Node::logSuccess(Transaction transaction) {
-    Message message(transaction.request);
+void MP2Node::logSuccess(const Transaction &transaction) {
+    Message message = Message::decode(transaction.request);
     switch (message.type) {
         case CREATE:
             log->logCreateSuccess(&(getMemberNode()->addr), true, message.transID, message.key, message.value);
@@ -481,14 +2390,16 @@ void MP2Node::logSuccess(Transaction transaction) {
             break;
 
         case READ:
-            Message response(transaction.responses[0]);
-            log->logReadSuccess(&(getMemberNode()->addr), true, message.transID, message.key, response.value);
+            log->logReadSuccess(&(getMemberNode()->addr), true, message.transID, message.key, transaction.responses[0]);
+            break;
+
+        default:
             break;
     }
 }
 
-void MP2Node::logFailure(Transaction transaction) {
-    Message message(transaction.request);
+void MP2Node::logFailure(const Transaction &transaction) {
+    Message message = Message::decode(transaction.request);
     switch (message.type) {
         case CREATE:
             log->logCreateFail(&(getMemberNode()->addr), true, message.transID, message.key, message.value);
@@ -505,82 +2416,296 @@ void MP2Node::logFailure(Transaction transaction) {
         case DELETE:
             log->logDeleteFail(&(getMemberNode()->addr), true, message.transID, message.key);
             break;
+
+        default:
+            break;
     }
 }
 
-void MP2Node::removeTrnsaction(int transId) {
-    transactions.erase(transId);
-}
 
+/**
+ * FUNCTION NAME: findNeighbors
+ *
+ * DESCRIPTION: Refresh the two successors holding my replicas and the two predecessors
+ * 				whose replicas I hold. With zones, virtual nodes or another placement,
+ * 				those are the other replicas of the keys I am primary of and the primaries
+ * 				of the keys I replicate, each member once
+ */
+void MP2Node::findNeighbors() {
+    hasMyReplicas.clear();
+    haveReplicasOf.clear();
 
-vector<Node> MP2Node::getNewHROs() {
     Node self(getMemberNode()->addr);
-    vector<Node> hros;
-
-    self.computeHashCode();
-
-    std::vector<Node>::const_iterator it = std::find_if(ring.begin(), ring.end(), [this, self](const Node& node){
-        return node.nodeHashCode == self.nodeHashCode;
-    });
-
-    if(it != ring.end()) {
-        hros.push_back(it[-1]);
-        hros.push_back(it[-2]);
+    vector<Node>::iterator it = std::lower_bound(ring.begin(), ring.end(), self);
+    if (ringNodes(ring) < REPLICAS || !inRing(self)) {
+        return;
     }
 
-    vector<Node> newHros;
+    size_t i = it - ring.begin();
+    if (par->ZONE_COUNT > 1 || par->VNODES > 1 || par->PLACEMENT != RING_PLACEMENT) {
+        auto isSelf = [&self](const Node &n) {
+            return !memcmp(n.nodeAddress.addr, self.nodeAddress.addr, sizeof(n.nodeAddress.addr));
+        };
+        auto addOnce = [](vector<Node> &nodes, const Node &node) {
+            bool known = std::any_of(nodes.begin(), nodes.end(), [&node](const Node &n) {
+                return !memcmp(n.nodeAddress.addr, node.nodeAddress.addr, sizeof(n.nodeAddress.addr));
+            });
+            if (!known) {
+                nodes.push_back(node);
+            }
+        };
+        // On the ring, the tokens are walked back from my first one
+        size_t sets = ringIndex.replicas.size();
+        size_t start = ringIndex.placement == RING_PLACEMENT ? i : 0;
+        for (size_t k = 0; k < sets; k++) {
+            ReplicaSet &replicas = ringIndex.replicas[(start + sets - k) % sets];
+            Node &primary = ring[replicas.index[0]];
+            if (isSelf(primary)) {
+                for (size_t j = 0; j < replicas.count; j++) {
+                    if (!isSelf(ring[replicas.index[j]])) {
+                        addOnce(hasMyReplicas, ring[replicas.index[j]]);
+                    }
+                }
+            } else if (holds(ring, replicas, self.nodeAddress)) {
+                addOnce(haveReplicasOf, primary);
+            }
+        }
+        return;
+    }
+    hasMyReplicas.push_back(ring[(i + 1) % ring.size()]);
+    hasMyReplicas.push_back(ring[(i + 2) % ring.size()]);
+    haveReplicasOf.push_back(ring[(i + ring.size() - 1) % ring.size()]);
+    haveReplicasOf.push_back(ring[(i + ring.size() - 2) % ring.size()]);
+}
 
-    std::set_difference(
-            hros.begin(), hros.end(),
-            haveReplicasOf.begin(), haveReplicasOf.end(),
-            std::back_inserter(newHros)
-    );
+bool MP2Node::amOwner(string_view key) {
+    ReplicaSet replicas = replicasOn(ringIndex, hashFunction(key));
+    return replicas.count > 0 &&
+           !memcmp(ring[replicas.index[0]].nodeAddress.addr, getMemberNode()->addr.addr, sizeof(getMemberNode()->addr.addr));
+}
 
-    haveReplicasOf.clear();
-    haveReplicasOf = hros;
 
-    return newHros;
+/**
+ * FUNCTION NAME: clearUnrelevantData
+ *
+ * DESCRIPTION: Drop the keys this node is no longer a replica of
+ */
+void MP2Node::clearUnrelevantData() {
+    Node self(getMemberNode()->addr);
+    auto it = ht->hashTable.begin();
+    while (it != ht->hashTable.end()) {
+        size_t pos = hashFunction(it->first);
+        if (holds(ring, replicasOn(ringIndex, pos), self.nodeAddress)) {
+            ++it;
+        } else {
+            entryChanged(pos, hashingEntries() ? MerkleTree::entryHash(it->first, it->second) : 0, 0);
+            versions.forget(it->first, pos);
+            keyIndex.erase(it->first, pos);
+            it = ht->hashTable.erase(it);
+        }
+    }
 }
 
-vector<Node> MP2Node::getNewHMRs() {
-    Node self(getMemberNode()->addr);
-    vector<Node> hmrs;
+/**
+ * FUNCTION NAME: catchUp
+ *
+ * DESCRIPTION: Run once we are in the ring after (re)joining. Keys restored from the
+ * 				snapshot that are not ours any more are dropped, and the nodes we share
+ * 				replicas with are asked for the writes made since catchUpSince. Without a
+ * 				snapshot there is nothing to ask for that stabilization does not push
+ */
+void MP2Node::catchUp() {
+    catchUpPending = false;
+    unsigned long restored = ht->currentSize();
+    clearUnrelevantData();
+    if (catchUpSince < 0) {
+        return;
+    }
 
-    self.computeHashCode();
+    vector<Node> peers;
+    vector<Node> neighbors(hasMyReplicas);
+    neighbors.insert(neighbors.end(), haveReplicasOf.begin(), haveReplicasOf.end());
+    std::for_each(neighbors.begin(), neighbors.end(), [&peers](const Node &n) {
+        bool known = std::any_of(peers.begin(), peers.end(), [&n](const Node &peer) {
+            return !memcmp(peer.nodeAddress.addr, n.nodeAddress.addr, sizeof(n.nodeAddress.addr));
+        });
+        if (!known) {
+            peers.push_back(n);
+        }
+    });
 
-    std::vector<Node>::const_iterator it = std::find_if(ring.begin(), ring.end(), [this, self](const Node& node){
-        return node.nodeHashCode == self.nodeHashCode;
+    int64_t since = catchUpSince;
+    Message message(-1, getMemberNode()->addr, CATCHUP, string((const char *) &since, sizeof(since)));
+    std::for_each(peers.begin(), peers.end(), [this, &message](Node &peer) {
+        send(message, peer.getAddress());
     });
+    log->LOG(&memberNode->addr, "#STATSLOG# rejoined: kept %lu of %lu keys, asked %zu nodes for writes since %ld",
+             ht->currentSize(), restored, peers.size(), catchUpSince);
+}
 
-    if(it != ring.end()) {
-        hmrs.push_back(it[1]);
-        hmrs.push_back(it[2]);
+/**
+ * FUNCTION NAME: answerCatchUp
+ *
+ * DESCRIPTION: Send a node that (re)joined the writes made after round since to the keys
+ * 				it is a replica of, deletes included. Only the ring ranges written since
+ * 				then are looked at. The requester may not be in our ring yet
+ */
+void MP2Node::answerCatchUp(Address requester, long since) {
+    Node joiner(requester);
+    vector <Node> r = ring;
+    if (!inRing(joiner)) {
+        vector <Node> tokens = tokensOf(requester);
+        insertTokens(r, tokens);
     }
-    vector<Node> newHmrs;
-
-    std::set_difference(
-            hmrs.begin(), hmrs.end(),
-            hasMyReplicas.begin(), hasMyReplicas.end(),
-            std::back_inserter(newHmrs)
-    );
+    RingIndex index;
+    indexRing(r, index);
 
-    hasMyReplicas.clear();
-    hasMyReplicas = hmrs;
-
-    return newHmrs;
+    vector <pair<string, KeyVersion>> changed;
+    for (size_t range = 0; range < VERSION_RANGES; range++) {
+        versions.changedSince(range, since, changed);
+    }
+    vector<TransferKey> keys;
+    std::for_each(changed.begin(), changed.end(), [&](const pair<string, KeyVersion> &kv) {
+        if (holds(r, replicasOn(index, hashFunction(kv.first)), requester)) {
+            keys.push_back(TransferKey{kv.first, kv.second.deleted});
+        }
+    });
+    long sent = keys.size();
+    streamKeys(requester, keys, true);
+    if (sent > 0) {
+        log->LOG(&memberNode->addr, "#STATSLOG# catch-up of %s: sent %ld writes since %ld",
+                 requester.getAddress().c_str(), sent, since);
+    }
 }
 
-void MP2Node::sendData(Node node, string k) {
-    Message message(-1, getMemberNode()->addr, CREATE, k, ht->read(k));
-    emulNet->ENsend(&(getMemberNode()->addr), node.getAddress(), message.toString());
+/**
+ * FUNCTION NAME: snapshotPath
+ *
+ * DESCRIPTION: Returns the file the snapshots of this node are written to
+ */
+string MP2Node::snapshotPath() {
+    return "node-" + to_string(*(int *) memberNode->addr.addr) + "-" +
+           to_string(*(short *) &memberNode->addr.addr[4]) + ".snapshot";
 }
 
-bool MP2Node::amOwner(string key) {
-    vector<Node> nodes = findNodes(key);
-    return Node(getMemberNode()->addr).getHashCode() == nodes[0].getHashCode();
+/**
+ * FUNCTION NAME: saveSnapshot
+ *
+ * DESCRIPTION: Write the store and its versions to disk. The file is replaced in one go,
+ * 				so a node going down mid-write keeps its previous snapshot. Format is a
+ * 				"time ringEpoch count" line, then per key a "stamp deleted keyLength
+ * 				valueLength" line followed by the key and the value
+ */
+void MP2Node::saveSnapshot() {
+    vector <pair<string, KeyVersion>> keys;
+    for (size_t range = 0; range < VERSION_RANGES; range++) {
+        versions.changedSince(range, -1, keys);
+    }
+    string path = snapshotPath();
+    string temp = path + ".tmp";
+    FILE *fp = fopen(temp.c_str(), "w");
+    if (fp == NULL) {
+        return;
+    }
+    fprintf(fp, "%d %ld %zu\n", par->getcurrtime(), ringEpoch, keys.size());
+    std::for_each(keys.begin(), keys.end(), [this, fp](const pair<string, KeyVersion> &kv) {
+        string value = kv.second.deleted ? "" : ht->read(kv.first);
+        fprintf(fp, "%ld %d %zu %zu\n", kv.second.stamp, kv.second.deleted, kv.first.size(), value.size());
+        fwrite(kv.first.data(), 1, kv.first.size(), fp);
+        fwrite(value.data(), 1, value.size(), fp);
+        fputc('\n', fp);
+    });
+    fclose(fp);
+    rename(temp.c_str(), path.c_str());
 }
 
+/**
+ * FUNCTION NAME: loadSnapshot
+ *
+ * DESCRIPTION: Restore the store from the last snapshot, if any. Writes made from a round
+ * 				trip before it on are caught up on, as replicas apply the same write up
+ * 				to a round trip apart. A snapshot taken before the tombstones still kept
+ * 				would bring deleted keys back, and is not restored
+ */
+void MP2Node::loadSnapshot() {
+    if (par->SNAPSHOT_PERIOD <= 0) {
+        return;
+    }
+    FILE *fp = fopen(snapshotPath().c_str(), "r");
+    if (fp == NULL) {
+        return;
+    }
+    int time;
+    long epoch;
+    size_t count;
+    if (fscanf(fp, "%d %ld %zu", &time, &epoch, &count) != 3) {
+        fclose(fp);
+        return;
+    }
+    if (par->TOMBSTONE_TTL > 0 && time < par->getcurrtime() - par->TOMBSTONE_TTL) {
+        // The deletes missed since have been forgotten and could not be caught up on
+        fclose(fp);
+        log->LOG(&memberNode->addr, "#STATSLOG# snapshot of time %d is older than the tombstones kept, not restored",
+                 time);
+        return;
+    }
+    fgetc(fp);
+    for (size_t i = 0; i < count; i++) {
+        long stamp;
+        int deleted;
+        size_t keyLength;
+        size_t valueLength;
+        if (fscanf(fp, "%ld %d %zu %zu", &stamp, &deleted, &keyLength, &valueLength) != 4) {
+            break;
+        }
+        fgetc(fp);
+        string key(keyLength, '\0');
+        string value(valueLength, '\0');
+        if (fread(&key[0], 1, keyLength, fp) != keyLength || fread(&value[0], 1, valueLength, fp) != valueLength) {
+            break;
+        }
+        fgetc(fp);
+        size_t pos = hashFunction(key);
+        if (!deleted && ht->create(key, value)) {
+            keyIndex.insert(key, pos);
+            entryChanged(pos, 0, hashingEntries() ? MerkleTree::entryHash(key, value) : 0);
+        }
+        versions.touch(key, pos, stamp, deleted);
+    }
+    fclose(fp);
 
-void MP2Node::clearUnrelevantData() {
+    catchUpSince = std::max(time - RTT, -1);
+    log->LOG(&memberNode->addr, "#STATSLOG# restored %lu keys from the snapshot of time %d, ring epoch %ld",
+             ht->currentSize(), time, epoch);
+}
 
+/**
+ * FUNCTION NAME: restart
+ *
+ * DESCRIPTION: Bring the store of a node that went down back, before the node rejoins:
+ * 				everything in memory is lost, the snapshot is reloaded and a catch-up
+ * 				is due once we are back in the ring
+ */
+void MP2Node::restart() {
+    ring.clear();
+    ringMembers = 0;
+    ringChecksum = 0;
+    indexRing(ring, ringIndex);
+    hasMyReplicas.clear();
+    haveReplicasOf.clear();
+    pendingEvents.clear();
+    transactions.clear();
+    transactionTimers.clear();
+    ht->clear();
+    keyIndex.clear();
+    transfers.clear();
+    receipts.clear();
+    merkleTrees.clear();
+    keyFilter.clear();
+    offers.clear();
+    rebalance.ranges.clear();
+    versions.clear();
+    catchUpSince = -1;
+    loadSnapshot();
+    catchUpPending = true;
 }
\ No newline at end of file
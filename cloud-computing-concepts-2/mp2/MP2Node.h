@@ -18,17 +18,121 @@
 #include "Params.h"
 #include "Message.h"
 #include "Queue.h"
+#include "MembershipEvent.h"
+#include "MembershipPiggyback.h"
+#include "KeyVersions.h"
+#include "KeyIndex.h"
+#include "RangeTransfer.h"
+#include "MerkleTree.h"
+#include "KeyFilter.h"
+#include "TransactionSlots.h"
+#include "TimerWheel.h"
 
 #include <map>
 
-struct Transaction {
-    int timestamp;
-    string request;
-    vector<string> responses;
-};
-
 #define QUORUM 2
 #define RTT 5
+// Number of replicas of every key
+#define REPLICAS 3
+// Entries of the MAGLEV_PLACEMENT lookup table, a prime well above the number of nodes
+#define MAGLEV_TABLE_SIZE 4099
+// Ring positions compared before and after a membership change to measure the keys moved
+#define PLACEMENT_SAMPLES 4096
+// Rounds between two sweeps of the expired tombstones
+#define TOMBSTONE_SWEEP 10
+
+/**
+ * STRUCT NAME: KeyRange
+ *
+ * DESCRIPTION: Ring positions (from, to], wrapping around. from == to is the whole ring
+ */
+typedef struct KeyRange {
+    size_t from;
+    size_t to;
+} KeyRange;
+
+/**
+ * STRUCT NAME: ReplicaSet
+ *
+ * DESCRIPTION: The replicas of a ring position, as the indices of their tokens in the
+ * 				ring it was looked up on. count is below REPLICAS only on a ring of fewer
+ * 				members
+ */
+typedef struct ReplicaSet {
+    size_t count;
+    size_t index[REPLICAS];
+} ReplicaSet;
+
+/**
+ * STRUCT NAME: RingIndex
+ *
+ * DESCRIPTION: Lookup structure of a ring, built once per ring epoch for the placement of
+ * 				Params. With RING_PLACEMENT, the positions of the tokens, packed for the
+ * 				binary search, and the replica set of the keys falling up to each token.
+ * 				Otherwise a token of each member, members in address order, their replica
+ * 				sets, and for MAGLEV_PLACEMENT the table giving the member of every slot
+ */
+typedef struct RingIndex {
+    int placement;
+    vector <size_t> positions;
+    vector <size_t> members;
+    vector <ReplicaSet> replicas;
+    vector <uint32_t> table;
+} RingIndex;
+
+/**
+ * STRUCT NAME: PlacementCost
+ *
+ * DESCRIPTION: Cost of the membership changes seen by one or more nodes: time spent
+ * 				rebuilding the ring index, and share of the key replicas that moved
+ */
+typedef struct PlacementCost {
+    long builds;
+    double buildMicros;
+    long changes;
+    double movedReplicas;
+    double movedOwners;
+} PlacementCost;
+
+/**
+ * STRUCT NAME: Rebalance
+ *
+ * DESCRIPTION: The stabilization protocol run as a background task, a slice of keys per
+ * 				round. oldRing is the ring the keys were placed on when the task started;
+ * 				ranges are the arcs still to go through, merged, the from of each being
+ * 				its cursor: the position of the last key done in it
+ */
+typedef struct Rebalance {
+    vector <Node> oldRing;
+    RingIndex oldIndex;
+    vector <KeyRange> ranges;
+    int started;
+    long scanned;
+    long queued;
+    long slices;
+    long restarts;
+} Rebalance;
+
+/**
+ * STRUCT NAME: RebalanceStats
+ *
+ * DESCRIPTION: Rebalancing tasks run by one or more nodes, the slices they took and the
+ * 				time those took
+ */
+typedef struct RebalanceStats {
+    long tasks;
+    // ring changes that came while a task was under way, and extended it
+    long restarts;
+    long finished;
+    long rounds;
+    long slices;
+    long scanned;
+    long queued;
+    // bytes of the records queued, for every replica they go to
+    long bytes;
+    double sliceMicros;
+    double maxSliceMicros;
+} RebalanceStats;
 
 /**
  * CLASS NAME: MP2Node
@@ -39,8 +143,16 @@ struct Transaction {
  * 				2) Stabilization Protocol
  * 				3) Server side CRUD APIs
  * 				4) Client side CRUD APIs
+ * 				5) Hand-off of the keys when this node leaves the group
+ * 				6) Snapshots of the store, and catch-up when this node rejoins: it
+ * 				   pulls the writes it missed from its neighbours, on top of the keys
+ * 				   stabilization pushes, which the Bloom filters mostly leave out
+ * 				7) Anti-entropy: replicas compare Merkle trees of the ranges they share
+ * 				   and repair the keys on which they differ
+ * 				8) Bloom filters of the keys held, so that stabilization leaves out the
+ * 				   keys a new replica already has
  */
-class MP2Node {
+class MP2Node : public MembershipListener {
 private:
     // Vector holding the next two neighbors in the ring who have my replicas
     vector <Node> hasMyReplicas;
@@ -48,11 +160,54 @@ private:
     vector <Node> haveReplicasOf;
     // Ring
     vector <Node> ring;
+    // Replica sets of the ring
+    RingIndex ringIndex;
+    // Members on the ring, and the xor of the hashes of their first tokens
+    size_t ringMembers;
+    unsigned long long ringChecksum;
+    // Membership changes not applied to the ring yet
+    vector <MembershipEvent> pendingEvents;
+    // Membership epoch the ring reflects
+    long ringEpoch;
     // Hash Table
     HashTable *ht;
-
-    // Hash Table to store transactions for quorum.
-    map<int, Transaction> transactions;
+    // When the keys of ht were last written, by ring range
+    KeyVersions versions;
+    // The keys of ht in ring order
+    KeyIndex keyIndex;
+    // Whether we have yet to settle in the ring after (re)joining; restored from a snapshot,
+    // we then pull from our neighbours the writes made since catchUpSince
+    bool catchUpPending;
+    long catchUpSince;
+    // Client requests served as a replica
+    long requestsServed;
+    // Ring index rebuilds and keys moved by them
+    PlacementCost placementCost;
+    // Stabilization under way, and the round of its last slice
+    Rebalance rebalance;
+    RebalanceStats rebalanceStats;
+    int lastSlice;
+
+    // Transactions waiting for quorum, by transID, and the rounds they time out at
+    TransactionSlots transactions;
+    TimerWheel transactionTimers;
+    // Replica transfers being streamed, by stream id, and those being received, by sender
+    // and stream id
+    map<int, RangeTransfer> transfers;
+    map<pair<uint64_t, int>, TransferReceipt> receipts;
+    int nextTransferId;
+    TransferStats transferStats;
+    // Records of the batch being sent, reused from batch to batch
+    string batchBuffer;
+    // Merkle trees of the ring ranges we are a replica of, by the position of their primary token
+    map<size_t, MerkleTree> merkleTrees;
+    AntiEntropyStats antiEntropyStats;
+    // Bloom filters of the keys we hold, and the keys offered to replicas against theirs, by id
+    KeyFilter keyFilter;
+    map<int, KeyOffer> offers;
+    FilterStats filterStats;
+    // Round each transaction that reached quorum started at, and the rounds it took
+    vector<pair<int, int>> opLatencies;
 
     // Member representing this member
     Member *memberNode;
@@ -62,10 +217,14 @@ private:
     EmulNet *emulNet;
     // Object of Log
     Log *log;
+    // Membership protocol riding on our messages, if any
+    MembershipPiggyback *piggyback;
+    // Binary form of the message being sent, reused from message to message
+    string wireBuffer;
+    // Membership delta of the message being sent, reused likewise
+    string piggybackBuffer;
 
-    vector <Node> getMembershipList();
-
-    size_t hashFunction(string key);
+    size_t hashFunction(string_view key);
 
     void findNeighbors();
 
@@ -75,41 +234,149 @@ private:
     void dispatchMessage(Message message, Address* address);
 
     // server
-    bool createKeyValue(string key, string value, ReplicaType replica);
+    bool createKeyValue(string_view key, string_view value, ReplicaType replica);
 
-    string readKey(string key);
+    string_view readKey(string_view key);
 
-    bool updateKeyValue(string key, string value, ReplicaType replica);
+    bool updateKeyValue(string_view key, string_view value, ReplicaType replica);
 
-    bool deletekey(string key);
+    bool deletekey(string_view key);
 
     // stabilization protocol - handle multiple failures
-    void stabilizationProtocol();
+    void stabilizationProtocol(vector <Node> &oldRing, RingIndex &oldIndex, vector <KeyRange> &affected);
+
+    static void mergeRanges(vector <KeyRange> &ranges);
+
+    void rebalanceSlice();
+
+    size_t rebalanceKey(size_t pos, const string &key, TransferQueue &queue);
+
+    void applyMembershipEvent(const MembershipEvent &event, vector <KeyRange> &affected);
+
+    KeyRange affectedRange(vector <Node> &r, size_t index);
+
+    vector <Node> tokensOf(const Address &address);
+
+    void insertTokens(vector <Node> &r, vector <Node> &tokens);
+
+    size_t ringNodes(vector <Node> &r);
+
+    ReplicaSet replicaSetAt(vector <Node> &r, const vector <size_t> &order, size_t first);
 
-    void handleMessage(Message msg);
+    void buildMaglevTable(vector <Node> &r, const vector <size_t> &members, vector <uint32_t> &table);
+
+    static uint32_t jumpHash(uint64_t key, uint32_t buckets);
+
+    void measurePlacement(vector <Node> &oldRing, RingIndex &oldIndex);
+
+    void indexRing(vector <Node> &r, RingIndex &index);
+
+    ReplicaSet replicasOn(const RingIndex &index, size_t pos);
+
+    bool holds(vector <Node> &r, const ReplicaSet &replicas, const Address &address);
+
+    bool inRing(const Node &node);
+
+    void handleMessage(const MessageView &msg);
 
     void recordTransaction(Message msg);
 
-    void recordTransactionReply(Message msg);
+    void recordTransactionReply(const MessageView &msg);
 
     void checkForQuorum();
 
-    void logSuccess(Transaction);
+    void logSuccess(const Transaction &transaction);
+
+    void logFailure(const Transaction &transaction);
+
+    int send(Message &message, Address *address);
+
+    int send(MessageView &message, Address *address);
+
+    size_t payloadBudget(size_t keySize);
+
+    static void queueTransfer(TransferQueue &queue, const Address &to, string_view key, bool deleted);
 
-    void logFailure(Transaction);
+    void streamKeys(Address to, vector <TransferKey> &keys, bool tracked);
 
-    void removeTrnsaction(int);
+    void fillWindow(RangeTransfer &transfer, int id);
 
-    vector<Node> getNewHROs();
+    void sendBatch(RangeTransfer &transfer, int id, uint32_t seq);
 
-    vector<Node> getNewHMRs();
+    void pumpTransfers();
 
-    void sendData(Node node, string k);
+    void applyRecord(string_view key, string_view value, bool deleted, long stamp);
 
-    bool amOwner(string key);
+    void receiveBatch(const MessageView &message);
+
+    void transferAcked(const MessageView &message);
+
+    bool streamingTo(const Address &address);
+
+    void buildMerkleTrees();
+
+    MerkleTree *merkleTreeOf(size_t pos);
+
+    void redigest(size_t pos, uint64_t change);
+
+    bool hashingEntries();
+
+    void entryChanged(size_t pos, uint64_t removed, uint64_t added);
+
+    void growFilter(size_t pos);
+
+    KeyState stateOf(string_view key, size_t pos);
+
+    void leafKeys(MerkleTree &tree, uint32_t node, vector<pair<size_t, string>> &keys);
+
+    void sendAntiEntropy(MessageView &message, Address to);
+
+    void startAntiEntropy();
+
+    void compareNodes(const MessageView &message);
+
+    void answerLeaf(const MessageView &message);
+
+    void repairLeaf(const MessageView &message);
+
+    void answerPull(const MessageView &message);
+
+    void sendFilterMessage(MessageView &message, Address to);
+
+    void offerKeys(Address to, vector <TransferKey> &keys);
+
+    void sendFilters(const MessageView &message);
+
+    void filtersArrived(const MessageView &message);
+
+    void confirmKeys(map<int, KeyOffer>::iterator it);
+
+    void answerConfirm(const MessageView &message);
+
+    void confirmArrived(const MessageView &message);
+
+    void expireOffers();
+
+    void reply(const MessageView &request, MessageType type, string_view value);
+
+    bool amOwner(string_view key);
 
     void clearUnrelevantData();
 
+    void handOff();
+
+    void catchUp();
+
+    void answerCatchUp(Address requester, long since);
+
+    string snapshotPath();
+
+    void saveSnapshot();
+
+    void sweepTombstones();
+
+    void loadSnapshot();
+
 public:
     MP2Node(Member *memberNode, Params *par, EmulNet *emulNet, Log *log, Address *addressOfMember);
 
@@ -126,8 +393,11 @@ public:
 
     void clientDelete(string key);
 
-    // find the addresses of nodes that are responsible for a key
-    vector <Node> findNodes(string key);
+    // find the nodes that are responsible for a key
+    ReplicaSet findNodes(string_view key);
+
+    // address of the i-th replica of a set found by findNodes
+    Address *replicaAddress(const ReplicaSet &replicas, size_t i);
 
     // handle messages from receiving queue
     void checkMessages();
@@ -138,6 +408,37 @@ public:
     // ring functionalities
     void updateRing();
 
+    // membership events from MP1Node
+    void membershipChanged(const MembershipEvent &event);
+
+    void setPiggyback(MembershipPiggyback *piggyback);
+
+    void restart();
+
+    const vector<pair<int, int>> &getOpLatencies();
+
+    void addStoreUsage(TableUsage &usage);
+
+    long getRequestsServed();
+
+    unsigned long getKeyCount();
+
+    double ringShare();
+
+    void addPlacementCost(PlacementCost &cost);
+
+    void addTransferStats(TransferStats &stats);
+
+    void addAntiEntropyStats(AntiEntropyStats &stats);
+
+    void addFilterStats(FilterStats &stats);
+
+    bool rebalancing();
+
+    void addRebalanceStats(RebalanceStats &stats);
+
+    void preload(string_view key, string_view value);
+
     ~MP2Node();
 };
 
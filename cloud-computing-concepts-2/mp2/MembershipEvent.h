@@ -0,0 +1,46 @@
+/**********************************
+ * FILE NAME: MembershipEvent.h
+ *
+ * DESCRIPTION: Membership change events published by the Membership Protocol (MP1Node)
+ **********************************/
+
+#ifndef MEMBERSHIPEVENT_H_
+#define MEMBERSHIPEVENT_H_
+
+#include "stdincludes.h"
+#include "Member.h"
+
+/**
+ * Membership event types
+ */
+enum MembershipEventType {
+    MEMBER_JOINED,
+    MEMBER_LEFT,
+    MEMBER_FAILED
+};
+
+/**
+ * STRUCT NAME: MembershipEvent
+ *
+ * DESCRIPTION: A member joined, left or was detected as failed. Every event moves the
+ * 				membership epoch of the publishing node forward by one.
+ */
+typedef struct MembershipEvent {
+    MembershipEventType type;
+    Address addr;
+    long epoch;
+} MembershipEvent;
+
+/**
+ * CLASS NAME: MembershipListener
+ *
+ * DESCRIPTION: Interface of the subscribers of a membership event stream
+ */
+class MembershipListener {
+public:
+    virtual void membershipChanged(const MembershipEvent &event) = 0;
+
+    virtual ~MembershipListener() {}
+};
+
+#endif /* MEMBERSHIPEVENT_H_ */
@@ -0,0 +1,38 @@
+/**********************************
+ * FILE NAME: MembershipPiggyback.h
+ *
+ * DESCRIPTION: Membership state carried by the messages of another protocol
+ **********************************/
+
+#ifndef MEMBERSHIPPIGGYBACK_H_
+#define MEMBERSHIPPIGGYBACK_H_
+
+#include "stdincludes.h"
+#include "Member.h"
+
+/**
+ * Macros
+ */
+// Bytes of a membership entry riding on a message: the 6 raw bytes of the member's address,
+// then its heartbeat as an int64, in host byte order
+#define PIGGYBACK_ENTRY_SIZE (sizeof(((Address *) 0)->addr) + sizeof(int64_t))
+
+/**
+ * CLASS NAME: MembershipPiggyback
+ *
+ * DESCRIPTION: Interface through which the key-value store (MP2Node) lets the membership
+ * 				protocol ride on its messages. Every outgoing message carries the delta
+ * 				outgoing appends to a buffer of the caller, PIGGYBACK_ENTRY_SIZE bytes per
+ * 				entry; every received one hands its delta to incoming, which reads it in
+ * 				place and also takes it as proof that the sender is alive.
+ */
+class MembershipPiggyback {
+public:
+    virtual void outgoing(Address *to, string &out) = 0;
+
+    virtual void incoming(string_view delta) = 0;
+
+    virtual ~MembershipPiggyback() {}
+};
+
+#endif /* MEMBERSHIPPIGGYBACK_H_ */
@@ -0,0 +1,207 @@
+/**********************************
+ * FILE NAME: MerkleTree.cpp
+ *
+ * DESCRIPTION: MerkleTree class definition
+ **********************************/
+
+#include "MerkleTree.h"
+#include "Node.h"
+#include "RangeTransfer.h"
+
+/**
+ * Constructor
+ */
+MerkleTree::MerkleTree(size_t owner, size_t from, size_t to) {
+    this->owner = owner;
+    this->from = from;
+    this->to = to;
+    hashes.assign(2 * MERKLE_LEAVES - 1, 0);
+}
+
+/**
+ * Destructor
+ */
+MerkleTree::~MerkleTree() {}
+
+/**
+ * FUNCTION NAME: span
+ *
+ * DESCRIPTION: Returns the number of ring positions in the range, 2^64 for the whole ring
+ */
+unsigned __int128 MerkleTree::span() const {
+    return from == to ? (unsigned __int128) 1 << 64 : (unsigned __int128) (size_t) (to - from);
+}
+
+/**
+ * FUNCTION NAME: entryHash
+ *
+ * DESCRIPTION: Returns the hash a key holding value adds to its leaf. Replicas holding the
+ * 				same value for a key add the same hash, whenever they wrote it
+ */
+uint64_t MerkleTree::entryHash(string_view key, string_view value) {
+    std::hash <string_view> hashFunc;
+    return Node::mixHash(hashFunc(key) ^ Node::mixHash(hashFunc(value)));
+}
+
+/**
+ * FUNCTION NAME: ownerOf
+ *
+ * DESCRIPTION: Returns the owner of the tree label names
+ */
+size_t MerkleTree::ownerOf(string_view label) {
+    size_t owner = 0;
+    if (label.size() == MERKLE_LABEL_SIZE) {
+        memcpy(&owner, label.data(), sizeof(owner));
+    }
+    return owner;
+}
+
+/**
+ * FUNCTION NAME: isLeaf
+ *
+ * DESCRIPTION: Whether node is a leaf
+ */
+bool MerkleTree::isLeaf(uint32_t node) {
+    return node >= MERKLE_LEAVES - 1;
+}
+
+/**
+ * FUNCTION NAME: appendNode
+ *
+ * DESCRIPTION: Append a node and its hash to out, in host byte order
+ */
+void MerkleTree::appendNode(string &out, uint32_t node, uint64_t hash) {
+    out.append((const char *) &node, sizeof(node));
+    out.append((const char *) &hash, sizeof(hash));
+}
+
+/**
+ * FUNCTION NAME: nextNode
+ *
+ * DESCRIPTION: Read the first node of in and move in past it
+ *
+ * RETURNS:
+ * false at the end of in, or if the node is not one of a tree
+ */
+bool MerkleTree::nextNode(string_view &in, uint32_t &node, uint64_t &hash) {
+    if (in.size() < MERKLE_NODE_SIZE) {
+        return false;
+    }
+    memcpy(&node, in.data(), sizeof(node));
+    memcpy(&hash, in.data() + sizeof(node), sizeof(hash));
+    in.remove_prefix(MERKLE_NODE_SIZE);
+    return node < 2 * MERKLE_LEAVES - 1;
+}
+
+/**
+ * FUNCTION NAME: appendEntry
+ *
+ * DESCRIPTION: Append the state of key to out, as a record of a TRANSFER batch with the
+ * 				stamp of the key, whose value is the hash; a tombstone has none
+ */
+void MerkleTree::appendEntry(string &out, string_view key, const KeyState &state) {
+    char value[MERKLE_STATE_SIZE];
+    memcpy(value, &state.hash, sizeof(state.hash));
+    TransferBatch::append(out, key, string_view(value, sizeof(value)), state.deleted, state.stamp);
+}
+
+/**
+ * FUNCTION NAME: nextEntry
+ *
+ * DESCRIPTION: Read the first key state of in and move in past it
+ *
+ * RETURNS:
+ * false at the end of in, or if the entry is malformed
+ */
+bool MerkleTree::nextEntry(string_view &in, string_view &key, KeyState &state) {
+    string_view value;
+    if (!TransferBatch::next(in, key, value, state.deleted, state.stamp)) {
+        return false;
+    }
+    state.hash = 0;
+    if (state.deleted) {
+        return true;
+    }
+    if (value.size() != MERKLE_STATE_SIZE) {
+        return false;
+    }
+    memcpy(&state.hash, value.data(), sizeof(state.hash));
+    return true;
+}
+
+/**
+ * FUNCTION NAME: entrySize
+ *
+ * DESCRIPTION: Returns the bytes the state of key takes at most, a tombstone having no hash
+ */
+size_t MerkleTree::entrySize(string_view key) {
+    return TransferBatch::recordSize(key, string_view()) + MERKLE_STATE_SIZE;
+}
+
+/**
+ * FUNCTION NAME: label
+ *
+ * DESCRIPTION: Append to out the owner and range of this tree, which a replica matches
+ * 				with its own tree of the same keys
+ */
+void MerkleTree::label(string &out) const {
+    out.append((const char *) &owner, sizeof(owner));
+    out.append((const char *) &from, sizeof(from));
+    out.append((const char *) &to, sizeof(to));
+}
+
+/**
+ * FUNCTION NAME: matches
+ *
+ * DESCRIPTION: Whether label names a tree of the same owner and range. Replicas whose
+ * 				rings differ do not compare their trees
+ */
+bool MerkleTree::matches(string_view label) const {
+    string own;
+    this->label(own);
+    return label == own;
+}
+
+/**
+ * FUNCTION NAME: toggle
+ *
+ * DESCRIPTION: Xor hash into the leaf of ring position pos and its ancestors: adds the
+ * 				hash of an entry, or removes it when it is there
+ */
+void MerkleTree::toggle(size_t pos, uint64_t hash) {
+    size_t offset = pos - from - 1;
+    unsigned __int128 leaf = (unsigned __int128) offset * MERKLE_LEAVES / span();
+    uint32_t node = (uint32_t) std::min(leaf, (unsigned __int128) MERKLE_LEAVES - 1) + MERKLE_LEAVES - 1;
+    while (true) {
+        hashes[node] ^= hash;
+        if (node == 0) {
+            break;
+        }
+        node = (node - 1) / 2;
+    }
+}
+
+/**
+ * FUNCTION NAME: hashOf
+ *
+ * DESCRIPTION: Returns the hash of node
+ */
+uint64_t MerkleTree::hashOf(uint32_t node) const {
+    return hashes[node];
+}
+
+/**
+ * FUNCTION NAME: leafRange
+ *
+ * DESCRIPTION: Ring positions (lo, hi] of the arc of leaf node
+ *
+ * RETURNS:
+ * false if the arc is empty, the range being narrower than MERKLE_LEAVES positions
+ */
+bool MerkleTree::leafRange(uint32_t node, size_t &lo, size_t &hi) const {
+    unsigned __int128 leaf = node - (MERKLE_LEAVES - 1);
+    // The arc of a leaf holds the offsets that toggle rounds down to it
+    lo = from + (size_t) ((leaf * span() + MERKLE_LEAVES - 1) / MERKLE_LEAVES);
+    hi = from + (size_t) (((leaf + 1) * span() + MERKLE_LEAVES - 1) / MERKLE_LEAVES);
+    return lo != hi;
+}
@@ -0,0 +1,107 @@
+/**********************************
+ * FILE NAME: MerkleTree.h
+ *
+ * DESCRIPTION: Header file of MerkleTree class
+ **********************************/
+
+#ifndef MERKLETREE_H_
+#define MERKLETREE_H_
+
+#include "stdincludes.h"
+
+/**
+ * Macros
+ */
+// Levels below the root; a tree has 2^MERKLE_DEPTH leaves
+#define MERKLE_DEPTH 10
+#define MERKLE_LEAVES (1 << MERKLE_DEPTH)
+// Bytes of a label: owner, from and to
+#define MERKLE_LABEL_SIZE (3 * sizeof(size_t))
+// Bytes of a node sent for comparison: its index and its hash
+#define MERKLE_NODE_SIZE (sizeof(uint32_t) + sizeof(uint64_t))
+// Bytes of the value of the state of a key sent for comparison: its hash. The stamp and
+// the tombstone are those of the record
+#define MERKLE_STATE_SIZE sizeof(uint64_t)
+
+/**
+ * STRUCT NAME: AntiEntropyStats
+ *
+ * DESCRIPTION: Merkle tree exchanges run by one or more nodes, and the keys they repaired
+ */
+typedef struct AntiEntropyStats {
+    // root hashes sent, and of those the ones that differed
+    long exchanges;
+    long diverged;
+    long messages;
+    long bytes;
+    long leaves;
+    // keys sent to a replica, and asked of it
+    long pushed;
+    long pulled;
+} AntiEntropyStats;
+
+/**
+ * STRUCT NAME: KeyState
+ *
+ * DESCRIPTION: What a replica holds for a key: the round the key was written at, kept
+ * 				as is when a replica transfer brings the key over, and the hash of its
+ * 				entry, or a tombstone. A key it never had is a tombstone of round -1
+ */
+typedef struct KeyState {
+    long stamp;
+    uint64_t hash;
+    bool deleted;
+} KeyState;
+
+/**
+ * CLASS NAME: MerkleTree
+ *
+ * DESCRIPTION: Hash tree of the keys of the ring range (from, to], wrapping around, whose
+ * 				replicas have the primary token at position owner. The range is cut into
+ * 				MERKLE_LEAVES equal arcs; a leaf is the xor of the hashes of the keys and
+ * 				values in its arc and an inner node the xor of its children, so a write
+ * 				updates one leaf and its ancestors, in any order. Nodes are kept as a heap:
+ * 				the root is 0 and the children of i are 2i + 1 and 2i + 2.
+ */
+class MerkleTree {
+private:
+    size_t owner;
+    size_t from;
+    size_t to;
+    vector <uint64_t> hashes;
+
+    unsigned __int128 span() const;
+
+public:
+    MerkleTree(size_t owner, size_t from, size_t to);
+
+    static uint64_t entryHash(string_view key, string_view value);
+
+    static size_t ownerOf(string_view label);
+
+    static bool isLeaf(uint32_t node);
+
+    static void appendNode(string &out, uint32_t node, uint64_t hash);
+
+    static bool nextNode(string_view &in, uint32_t &node, uint64_t &hash);
+
+    static void appendEntry(string &out, string_view key, const KeyState &state);
+
+    static bool nextEntry(string_view &in, string_view &key, KeyState &state);
+
+    static size_t entrySize(string_view key);
+
+    void label(string &out) const;
+
+    bool matches(string_view label) const;
+
+    void toggle(size_t pos, uint64_t hash);
+
+    uint64_t hashOf(uint32_t node) const;
+
+    bool leafRange(uint32_t node, size_t &lo, size_t &hi) const;
+
+    virtual ~MerkleTree();
+};
+
+#endif /* MERKLETREE_H_ */
@@ -14,8 +14,18 @@
 // transID::fromAddr::DELETE::key
 // transID::fromAddr::REPLY::sucess
 // transID::fromAddr::READREPLY::value
+// transID::fromAddr::CATCHUP::since, an int64 in binary form
+// transID::fromAddr::TRANSFER::seq, and likewise for TRANSFERACK, whose sequence numbers
+// and records only travel in binary form
+// transID::fromAddr::MERKLE::label, and likewise for MERKLEKEYS and MERKLEPULL, whose
+// nodes and records only travel in binary form
+// transID::fromAddr::FILTERREQ::ranges, and likewise for FILTERREP, CONFIRMREQ and
+// CONFIRMREP, whose filters and digests only travel in binary form
+// any of them optionally followed by ::piggyback
 Message::Message(string message) {
     this->delimiter = "::";
+    replica = PRIMARY;
+    success = false;
     vector <string> tuple;
     size_t pos = message.find(delimiter);
     size_t start = 0;
@@ -31,6 +41,7 @@ Message::Message(string message) {
     Address addr(tuple.at(1));
     fromAddr = addr;
     type = static_cast<MessageType>(stoi(tuple.at(2)));
+    size_t fields = 4;
     switch (type) {
         case CREATE:
         case UPDATE:
@@ -38,9 +49,20 @@ Message::Message(string message) {
             value = tuple.at(4);
             if (tuple.size() > 5)
                 replica = static_cast<ReplicaType>(stoi(tuple.at(5)));
+            fields = 6;
             break;
         case READ:
         case DELETE:
+        case CATCHUP:
+        case TRANSFER:
+        case TRANSFERACK:
+        case MERKLE:
+        case MERKLEKEYS:
+        case MERKLEPULL:
+        case FILTERREQ:
+        case FILTERREP:
+        case CONFIRMREQ:
+        case CONFIRMREP:
             key = tuple.at(3);
             break;
         case REPLY:
@@ -53,6 +75,8 @@ Message::Message(string message) {
             value = tuple.at(3);
             break;
     }
+    if (tuple.size() > fields)
+        piggyback = tuple.at(fields);
 }
 
 /**
@@ -61,6 +85,7 @@ Message::Message(string message) {
 // construct a create or update message
 Message::Message(int _transID, Address _fromAddr, MessageType _type, string _key, string _value, ReplicaType _replica) {
     this->delimiter = "::";
+    success = false;
     transID = _transID;
     fromAddr = _fromAddr;
     type = _type;
@@ -81,6 +106,7 @@ Message::Message(const Message &anotherMessage) {
     this->transID = anotherMessage.transID;
     this->type = anotherMessage.type;
     this->value = anotherMessage.value;
+    this->piggyback = anotherMessage.piggyback;
 }
 
 /**
@@ -88,6 +114,8 @@ Message::Message(const Message &anotherMessage) {
  */
 Message::Message(int _transID, Address _fromAddr, MessageType _type, string _key, string _value) {
     this->delimiter = "::";
+    replica = PRIMARY;
+    success = false;
     transID = _transID;
     fromAddr = _fromAddr;
     type = _type;
@@ -98,9 +126,11 @@ Message::Message(int _transID, Address _fromAddr, MessageType _type, string _key
 /**
  * Constructor
  */
-// construct a read or delete message
+// construct a read, delete or catch-up message
 Message::Message(int _transID, Address _fromAddr, MessageType _type, string _key) {
     this->delimiter = "::";
+    replica = PRIMARY;
+    success = false;
     transID = _transID;
     fromAddr = _fromAddr;
     type = _type;
@@ -113,6 +143,7 @@ Message::Message(int _transID, Address _fromAddr, MessageType _type, string _key
 // construct reply message
 Message::Message(int _transID, Address _fromAddr, MessageType _type, bool _success) {
     this->delimiter = "::";
+    replica = PRIMARY;
     transID = _transID;
     fromAddr = _fromAddr;
     type = _type;
@@ -125,6 +156,8 @@ Message::Message(int _transID, Address _fromAddr, MessageType _type, bool _succe
 // construct read reply message
 Message::Message(int _transID, Address _fromAddr, string _value) {
     this->delimiter = "::";
+    replica = PRIMARY;
+    success = false;
     transID = _transID;
     fromAddr = _fromAddr;
     type = READREPLY;
@@ -145,6 +178,16 @@ string Message::toString() {
             break;
         case READ:
         case DELETE:
+        case CATCHUP:
+        case TRANSFER:
+        case TRANSFERACK:
+        case MERKLE:
+        case MERKLEKEYS:
+        case MERKLEPULL:
+        case FILTERREQ:
+        case FILTERREP:
+        case CONFIRMREQ:
+        case CONFIRMREP:
             message += key;
             break;
         case REPLY:
@@ -157,9 +200,177 @@ string Message::toString() {
             message += value;
             break;
     }
+    if (!piggyback.empty())
+        message += delimiter + piggyback;
     return message;
 }
 
+/**
+ * FUNCTION NAME: appendField
+ *
+ * DESCRIPTION: Append a length-prefixed field to a binary message
+ */
+static void appendField(string &bytes, string_view field) {
+    // Longer fields would not fit in MAX_MSG_SIZE anyway
+    uint16_t size = std::min(field.size(), (size_t) UINT16_MAX);
+    bytes.append((const char *) &size, sizeof(size));
+    bytes.append(field.data(), size);
+}
+
+/**
+ * FUNCTION NAME: readField
+ *
+ * DESCRIPTION: Read the length-prefixed field at at, moving at past it
+ *
+ * RETURNS:
+ * false if the field runs past end
+ */
+static bool readField(const char *&at, const char *end, string_view &field) {
+    uint16_t size;
+    if ((size_t) (end - at) < sizeof(size)) {
+        return false;
+    }
+    memcpy(&size, at, sizeof(size));
+    at += sizeof(size);
+    if ((size_t) (end - at) < size) {
+        return false;
+    }
+    field = string_view(at, size);
+    at += size;
+    return true;
+}
+
+/**
+ * Constructor
+ */
+MessageView::MessageView() {
+    type = CREATE;
+    replica = PRIMARY;
+    success = false;
+    transID = 0;
+}
+
+/**
+ * Constructor
+ */
+// construct the header of a message, with empty fields
+MessageView::MessageView(int _transID, const Address &_fromAddr, MessageType _type) {
+    type = _type;
+    replica = PRIMARY;
+    success = false;
+    transID = _transID;
+    fromAddr = _fromAddr;
+}
+
+/**
+ * FUNCTION NAME: parse
+ *
+ * DESCRIPTION: Parse a binary message in place, without allocating. The header has a
+ * 				fixed layout and the fields are found by their lengths, so every field is
+ * 				located up front at no more cost than deferring it would have
+ *
+ * RETURNS:
+ * false if the message is malformed
+ */
+bool MessageView::parse(const char *data, size_t size) {
+    if (size < WIRE_HEADER_SIZE || (unsigned char) data[0] > CONFIRMREP || (unsigned char) data[1] > TERTIARY) {
+        return false;
+    }
+    type = static_cast<MessageType>(data[0]);
+    replica = static_cast<ReplicaType>(data[1]);
+    success = data[2] != 0;
+    int32_t id;
+    memcpy(&id, data + 3, sizeof(id));
+    transID = id;
+    memcpy(fromAddr.addr, data + 3 + sizeof(id), sizeof(fromAddr.addr));
+
+    const char *at = data + WIRE_HEADER_SIZE;
+    const char *end = data + size;
+    return readField(at, end, key) && readField(at, end, value) && readField(at, end, piggyback);
+}
+
+/**
+ * FUNCTION NAME: encode
+ *
+ * DESCRIPTION: Append the binary form of the message to out. Like the text form, only the
+ * 				fields of its type are carried; keys and values may hold any byte
+ */
+void MessageView::encode(string &out) const {
+    bool hasKey = type == CREATE || type == UPDATE || type == READ || type == DELETE || type == CATCHUP ||
+                  type == TRANSFER || type == TRANSFERACK || type == MERKLE || type == MERKLEKEYS || type == MERKLEPULL ||
+                  type == FILTERREQ || type == FILTERREP || type == CONFIRMREQ || type == CONFIRMREP;
+    bool hasValue = type == CREATE || type == UPDATE || type == READREPLY || type == TRANSFER || type == MERKLE ||
+                    type == MERKLEKEYS || type == MERKLEPULL || type == FILTERREP || type == CONFIRMREQ ||
+                    type == CONFIRMREP;
+    out.reserve(out.size() + WIRE_HEADER_SIZE + 3 * sizeof(uint16_t) + (hasKey ? key.size() : 0) +
+                (hasValue ? value.size() : 0) + piggyback.size());
+
+    out.push_back((char) type);
+    out.push_back((char) (type == CREATE || type == UPDATE ? replica : PRIMARY));
+    out.push_back((char) ((type == REPLY || type == TRANSFER || type == MERKLEKEYS) && success));
+    int32_t id = transID;
+    out.append((const char *) &id, sizeof(id));
+    out.append(fromAddr.addr, sizeof(fromAddr.addr));
+    appendField(out, hasKey ? key : string_view());
+    appendField(out, hasValue ? value : string_view());
+    appendField(out, piggyback);
+}
+
+/**
+ * FUNCTION NAME: view
+ *
+ * DESCRIPTION: View over the fields of the message, valid while it is unchanged
+ */
+MessageView Message::view() const {
+    MessageView view(transID, fromAddr, type);
+    view.replica = replica;
+    view.success = success;
+    view.key = key;
+    view.value = value;
+    view.piggyback = piggyback;
+    return view;
+}
+
+/**
+ * FUNCTION NAME: encode
+ *
+ * DESCRIPTION: Serialized Message in binary form
+ */
+string Message::encode() {
+    string bytes;
+    view().encode(bytes);
+    return bytes;
+}
+
+/**
+ * Constructor
+ */
+// construct a message from a parsed binary one, copying its fields
+Message::Message(const MessageView &view) {
+    this->delimiter = "::";
+    type = view.type;
+    replica = view.replica;
+    success = view.success;
+    transID = view.transID;
+    fromAddr = view.fromAddr;
+    key = view.key;
+    value = view.value;
+    piggyback = view.piggyback;
+}
+
+/**
+ * FUNCTION NAME: decode
+ *
+ * DESCRIPTION: Message from the binary form of a message we encoded ourselves
+ */
+Message Message::decode(const string &bytes) {
+    MessageView view;
+    bool parsed = view.parse(bytes.data(), bytes.size());
+    assert(parsed);
+    (void) parsed;
+    return Message(view);
+}
+
 /**
  * Assignment operator overloading
  */
@@ -172,5 +383,6 @@ Message &Message::operator=(const Message &anotherMessage) {
     this->transID = anotherMessage.transID;
     this->type = anotherMessage.type;
     this->value = anotherMessage.value;
+    this->piggyback = anotherMessage.piggyback;
     return *this;
 }
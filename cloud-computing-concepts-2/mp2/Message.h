@@ -10,6 +10,53 @@
 #include "Member.h"
 #include "common.h"
 
+/**
+ * Macros
+ */
+// Binary form: a byte each for type, replica and success, the transID as an int32 and the
+// 6 raw bytes of fromAddr, then the key, the value and the piggyback, each as a uint16
+// length followed by its bytes. Host byte order, as the emulator never crosses machines.
+// A TRANSFER has its sequence number as a uint32 key, its packed records as value, and
+// success set on the last batch of its stream; a TRANSFERACK has the next sequence number
+// expected as a uint32 key, and a CATCHUP the round to catch up from as an int64 key. The
+// anti-entropy messages have the label of a Merkle tree as key; MERKLEKEYS has the leaf
+// as transID, and success set on an answer. The filter messages have the id of a key
+// offer as transID and a mask of ring ranges as key, CONFIRMREQ followed by its chunk
+// number, which is all the key of CONFIRMREP; FILTERREP has the filter of each range of
+// its mask as value, a uint16 length followed by its bits. The piggyback is
+// PIGGYBACK_ENTRY_SIZE bytes per membership entry
+#define WIRE_HEADER_SIZE 13
+
+/**
+ * CLASS NAME: MessageView
+ *
+ * DESCRIPTION: A binary message read in place: its key, value and piggyback are views into
+ * 				the buffer it came in, which must outlive it. Replies are built as views too,
+ * 				over the strings they send, so that nothing is copied until it is stored
+ */
+class MessageView {
+public:
+    MessageType type;
+    ReplicaType replica;
+    bool success;
+    int transID;
+    Address fromAddr;
+    string_view key;
+    string_view value;
+    string_view piggyback;
+
+    MessageView();
+
+    // construct the header of a message, with empty fields
+    MessageView(int _transID, const Address &_fromAddr, MessageType _type);
+
+    // parse the binary form, without allocating
+    bool parse(const char *data, size_t size);
+
+    // append the binary form to out
+    void encode(string &out) const;
+};
+
 /**
  * CLASS NAME: Message
  *
@@ -24,12 +71,17 @@ public:
     Address fromAddr;
     int transID;
     bool success; // success or not
+    // membership delta riding on the message, empty if none
+    string piggyback;
     // delimiter
     string delimiter;
 
-    // construct a message from a string
+    // construct a message from its text form
     Message(string message);
 
+    // construct a message from a parsed binary one, copying its fields
+    Message(const MessageView &view);
+
     Message(const Message &anotherMessage);
 
     // construct a create or update message
@@ -37,7 +89,7 @@ public:
 
     Message(int _transID, Address _fromAddr, MessageType _type, string _key, string _value, ReplicaType _replica);
 
-    // construct a read or delete message
+    // construct a read, delete or catch-up message
     Message(int _transID, Address _fromAddr, MessageType _type, string _key);
 
     // construct reply message
@@ -48,8 +100,17 @@ public:
 
     Message &operator=(const Message &anotherMessage);
 
-    // serialize to a string
+    // serialize to the text form
     string toString();
+
+    // view over the fields of this message
+    MessageView view() const;
+
+    // serialize to the binary form
+    string encode();
+
+    // decode the binary form of a message we encoded ourselves
+    static Message decode(const string &bytes);
 };
 
 #endif
@@ -0,0 +1,135 @@
+/**********************************
+ * FILE NAME: MessageBench.cpp
+ *
+ * DESCRIPTION: Microbenchmark of the text and binary forms of the key-value messages.
+ * 				Build with "make bench" and run ./MessageBench [iterations]
+ **********************************/
+
+#include "Message.h"
+#include <chrono>
+
+/**
+ * Macros
+ */
+#define BENCH_ITERATIONS 1000000
+
+/**
+ * Result sink, so that the work being timed is not optimized away
+ */
+static size_t sink = 0;
+
+/**
+ * FUNCTION NAME: sampleMessages
+ *
+ * DESCRIPTION: The messages of a CREATE, a READ and an UPDATE as the grader sends them:
+ * 				requests with a 5 byte key, replies and read replies, with piggybacks
+ */
+static vector <Message> sampleMessages() {
+    Address from("12:0");
+    vector <Message> messages;
+    messages.push_back(Message(1234, from, CREATE, "aB3xZ", "value42", PRIMARY));
+    messages.push_back(Message(1234, from, REPLY, true));
+    messages.push_back(Message(1235, from, READ, "aB3xZ"));
+    messages.push_back(Message(1235, from, "value42"));
+    messages.push_back(Message(1236, from, UPDATE, "aB3xZ", "value17", SECONDARY));
+    messages.push_back(Message(1237, from, DELETE, "aB3xZ"));
+    for (size_t i = 0; i < messages.size(); i += 2) {
+        messages[i].piggyback = "12,0,311;4,0,309;7,0,310;9,0,308";
+    }
+    return messages;
+}
+
+/**
+ * FUNCTION NAME: report
+ *
+ * DESCRIPTION: Print the time per message of a run
+ */
+static void report(const char *name, std::chrono::steady_clock::time_point start, long count) {
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    printf("%-24s %8.1f ns/msg\n", name, ns / count);
+}
+
+/**********************************
+ * FUNCTION NAME: main
+ *
+ * DESCRIPTION: Time encoding and decoding in both forms over the sample messages
+ **********************************/
+int main(int argc, char *argv[]) {
+    long iterations = argc > 1 ? atol(argv[1]) : BENCH_ITERATIONS;
+    vector <Message> messages = sampleMessages();
+    vector <string> text;
+    vector <string> binary;
+    size_t textBytes = 0;
+    size_t binaryBytes = 0;
+    for (size_t i = 0; i < messages.size(); i++) {
+        text.push_back(messages[i].toString());
+        binary.push_back(messages[i].encode());
+        textBytes += text.back().size();
+        binaryBytes += binary.back().size();
+    }
+    long count = iterations * messages.size();
+    printf("%zu messages, %ld iterations\n", messages.size(), iterations);
+    printf("%-24s %8.1f bytes/msg\n", "text size", (double) textBytes / messages.size());
+    printf("%-24s %8.1f bytes/msg\n", "binary size", (double) binaryBytes / messages.size());
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (long n = 0; n < iterations; n++) {
+        for (size_t i = 0; i < messages.size(); i++) {
+            sink += messages[i].toString().size();
+        }
+    }
+    report("text encode", start, count);
+
+    start = std::chrono::steady_clock::now();
+    for (long n = 0; n < iterations; n++) {
+        for (size_t i = 0; i < messages.size(); i++) {
+            sink += messages[i].encode().size();
+        }
+    }
+    report("binary encode", start, count);
+
+    start = std::chrono::steady_clock::now();
+    for (long n = 0; n < iterations; n++) {
+        for (size_t i = 0; i < text.size(); i++) {
+            Message message(text[i]);
+            sink += message.key.size() + message.transID;
+        }
+    }
+    report("text decode", start, count);
+
+    start = std::chrono::steady_clock::now();
+    for (long n = 0; n < iterations; n++) {
+        for (size_t i = 0; i < binary.size(); i++) {
+            MessageView view;
+            view.parse(binary[i].data(), binary[i].size());
+            Message message(view);
+            sink += message.key.size() + message.transID;
+        }
+    }
+    report("binary decode", start, count);
+
+    start = std::chrono::steady_clock::now();
+    for (long n = 0; n < iterations; n++) {
+        for (size_t i = 0; i < binary.size(); i++) {
+            MessageView view;
+            view.parse(binary[i].data(), binary[i].size());
+            sink += view.key.size() + view.transID;
+        }
+    }
+    report("binary parse in place", start, count);
+
+    string buffer;
+    start = std::chrono::steady_clock::now();
+    for (long n = 0; n < iterations; n++) {
+        for (size_t i = 0; i < binary.size(); i++) {
+            MessageView view;
+            view.parse(binary[i].data(), binary[i].size());
+            buffer.clear();
+            view.encode(buffer);
+            sink += buffer.size();
+        }
+    }
+    report("binary parse and resend", start, count);
+
+    return sink == 0;
+}
@@ -9,13 +9,16 @@
 /**
  * constructor
  */
-Node::Node() {}
+Node::Node() {
+    vnode = 0;
+}
 
 /**
  * constructor
  */
-Node::Node(Address address) {
+Node::Node(Address address, int vnode) {
     this->nodeAddress = address;
+    this->vnode = vnode;
     computeHashCode();
 }
 
@@ -27,10 +30,27 @@ Node::~Node() {}
 /**
  * FUNCTION NAME: computeHashCode
  *
- * DESCRIPTION: This function computes the hash code of the node address
+ * DESCRIPTION: This function computes the hash code of the token: all 6 bytes of the node
+ * 				address and the vnode number, mixed over the whole ring
  */
 void Node::computeHashCode() {
-    nodeHashCode = hashFunc(nodeAddress.addr) % RING_SIZE;
+    uint64_t bits = 0;
+    memcpy(&bits, nodeAddress.addr, sizeof(nodeAddress.addr));
+    bits |= (uint64_t) vnode << 48;
+    nodeHashCode = mixHash(bits);
+}
+
+/**
+ * FUNCTION NAME: mixHash
+ *
+ * DESCRIPTION: Spread the bits of value over a ring position, with the finalizer of
+ * 				SplitMix64: every input bit flips about half of the output bits
+ */
+size_t Node::mixHash(uint64_t value) {
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return (size_t) (value ^ (value >> 31));
 }
 
 /**
@@ -39,6 +59,7 @@ void Node::computeHashCode() {
 Node::Node(const Node &another) {
     this->nodeAddress = another.nodeAddress;
     this->nodeHashCode = another.nodeHashCode;
+    this->vnode = another.vnode;
 }
 
 /**
@@ -47,6 +68,7 @@ Node::Node(const Node &another) {
 Node &Node::operator=(const Node &another) {
     this->nodeAddress = another.nodeAddress;
     this->nodeHashCode = another.nodeHashCode;
+    this->vnode = another.vnode;
     return *this;
 }
 
@@ -54,7 +76,15 @@ Node &Node::operator=(const Node &another) {
  * operator overloading
  */
 bool Node::operator<(const Node &another) const {
-    return this->nodeHashCode < another.nodeHashCode;
+    if (this->nodeHashCode != another.nodeHashCode) {
+        return this->nodeHashCode < another.nodeHashCode;
+    }
+    // Tokens sharing a hash code are ordered the same way on every member
+    int order = memcmp(this->nodeAddress.addr, another.nodeAddress.addr, sizeof(this->nodeAddress.addr));
+    if (order != 0) {
+        return order < 0;
+    }
+    return this->vnode < another.vnode;
 }
 
 /**
@@ -10,15 +10,21 @@
 #include "stdincludes.h"
 #include "Member.h"
 
+/**
+ * CLASS NAME: Node
+ *
+ * DESCRIPTION: A token of a member on the ring: each member owns VNODES of them, numbered
+ * 				by vnode, at positions spread over the full range of size_t
+ */
 class Node {
 public:
     Address nodeAddress;
     size_t nodeHashCode;
-    std::hash <string> hashFunc;
+    int vnode;
 
     Node();
 
-    Node(Address address);
+    Node(Address address, int vnode = 0);
 
     Node(const Node &another);
 
@@ -28,6 +34,8 @@ public:
 
     void computeHashCode();
 
+    static size_t mixHash(uint64_t value);
+
     size_t getHashCode();
 
     Address *getAddress();
@@ -18,14 +18,91 @@ Params::Params() : PORTNUM(8001) {}
  */
 void Params::setparams(char *config_file) {
     //trace.funcEntry("Params::setparams");
-    char CRUD[10];
+    char CRUD[64] = "CREATE";
     FILE *fp = fopen(config_file, "r");
 
-    fscanf(fp, "MAX_NNB: %d", &MAX_NNB);
-    fscanf(fp, "\nSINGLE_FAILURE: %d", &SINGLE_FAILURE);
-    fscanf(fp, "\nDROP_MSG: %d", &DROP_MSG);
-    fscanf(fp, "\nMSG_DROP_PROB: %lf", &MSG_DROP_PROB);
-    fscanf(fp, "\nCRUD_TEST: %s", CRUD);
+    MAX_NNB = 10;
+    SINGLE_FAILURE = 0;
+    DROP_MSG = 0;
+    MSG_DROP_PROB = 0;
+    // Optional settings
+    GOSSIP_FANOUT = 0;
+    JOINREP_MAX_CHUNKS = 4;
+    JOINS_PER_TICK = 16;
+    JOIN_SEEDS = 1;
+    SEED_SELECTION = HASHED_SEED;
+    JOIN_TIMEOUT = 5;
+    FAILURE_DETECTOR = FIXED_TIMEOUT;
+    PHI_THRESHOLD = 8;
+    MEMBERSHIP_MODE = FULL_VIEW;
+    ACTIVE_VIEW_SIZE = 0;
+    PASSIVE_VIEW_SIZE = 0;
+    SHUFFLE_PERIOD = 5;
+    PIGGYBACK_ENTRIES = 4;
+    HEARTBEAT_SUPPRESS = 2;
+    ZONE_COUNT = 1;
+    CROSS_ZONE_GOSSIP = 0.1;
+    ZONE_DELAY = 1;
+    LEAVE_TIME = 0;
+    LEAVE_COUNT = 0;
+    SNAPSHOT_PERIOD = 0;
+    RESTART_TIME = 0;
+    VNODES = 1;
+    PLACEMENT = RING_PLACEMENT;
+    PLACEMENT_STATS = 0;
+    RANGE_TRANSFER = 1;
+    PRELOAD_KEYS = 0;
+    ANTI_ENTROPY_PERIOD = 10;
+    STABILIZE_FILTER = 1;
+    REBALANCE_KEYS = 4096;
+    REBALANCE_BYTES = 131072;
+    TOMBSTONE_TTL = 300;
+
+    // Settings are "KEY: value" lines, in any order; those left out keep their default
+    map<string, int *> ints = {
+        {"MAX_NNB", &MAX_NNB}, {"SINGLE_FAILURE", &SINGLE_FAILURE}, {"DROP_MSG", &DROP_MSG},
+        {"GOSSIP_FANOUT", &GOSSIP_FANOUT}, {"JOINREP_MAX_CHUNKS", &JOINREP_MAX_CHUNKS},
+        {"JOINS_PER_TICK", &JOINS_PER_TICK}, {"JOIN_SEEDS", &JOIN_SEEDS}, {"SEED_SELECTION", &SEED_SELECTION},
+        {"JOIN_TIMEOUT", &JOIN_TIMEOUT}, {"FAILURE_DETECTOR", &FAILURE_DETECTOR},
+        {"MEMBERSHIP_MODE", &MEMBERSHIP_MODE}, {"ACTIVE_VIEW_SIZE", &ACTIVE_VIEW_SIZE},
+        {"PASSIVE_VIEW_SIZE", &PASSIVE_VIEW_SIZE}, {"SHUFFLE_PERIOD", &SHUFFLE_PERIOD},
+        {"PIGGYBACK_ENTRIES", &PIGGYBACK_ENTRIES}, {"HEARTBEAT_SUPPRESS", &HEARTBEAT_SUPPRESS},
+        {"ZONE_COUNT", &ZONE_COUNT}, {"ZONE_DELAY", &ZONE_DELAY}, {"LEAVE_TIME", &LEAVE_TIME},
+        {"LEAVE_COUNT", &LEAVE_COUNT}, {"SNAPSHOT_PERIOD", &SNAPSHOT_PERIOD}, {"RESTART_TIME", &RESTART_TIME},
+        {"VNODES", &VNODES}, {"PLACEMENT", &PLACEMENT}, {"PLACEMENT_STATS", &PLACEMENT_STATS},
+        {"RANGE_TRANSFER", &RANGE_TRANSFER},
+        {"PRELOAD_KEYS", &PRELOAD_KEYS}, {"ANTI_ENTROPY_PERIOD", &ANTI_ENTROPY_PERIOD},
+        {"STABILIZE_FILTER", &STABILIZE_FILTER}, {"REBALANCE_KEYS", &REBALANCE_KEYS},
+        {"REBALANCE_BYTES", &REBALANCE_BYTES}, {"TOMBSTONE_TTL", &TOMBSTONE_TTL}
+    };
+    map<string, double *> doubles = {
+        {"MSG_DROP_PROB", &MSG_DROP_PROB}, {"PHI_THRESHOLD", &PHI_THRESHOLD}, {"CROSS_ZONE_GOSSIP", &CROSS_ZONE_GOSSIP}
+    };
+    char line[256];
+    while (fp != NULL && fgets(line, sizeof(line), fp) != NULL) {
+        char key[64];
+        char value[64];
+        if (sscanf(line, " %63[^: \t] : %63s", key, value) != 2) {
+            continue;
+        }
+        map<string, int *>::iterator i = ints.find(key);
+        map<string, double *>::iterator d = doubles.find(key);
+        if (i != ints.end()) {
+            *i->second = atoi(value);
+        } else if (d != doubles.end()) {
+            *d->second = atof(value);
+        } else if (!strcmp(key, "CRUD_TEST")) {
+            strcpy(CRUD, value);
+        } else {
+            cerr << "Unknown setting " << key << " in " << config_file << endl;
+        }
+    }
+    VNODES = std::max(VNODES, 1);
+    if (PLACEMENT < RING_PLACEMENT || PLACEMENT > JUMP_PLACEMENT) {
+        PLACEMENT = RING_PLACEMENT;
+    PLACEMENT_STATS = 0;
+    }
+    PRELOAD_KEYS = std::max(PRELOAD_KEYS, 0);
 
     if (0 == strcmp(CRUD, "CREATE")) {
         this->CRUDTEST = CREATE_TEST;
@@ -48,7 +125,9 @@ void Params::setparams(char *config_file) {
     for (unsigned int i = 0; i < EN_GPSZ; i++) {
         allNodesJoined += i;
     }
-    fclose(fp);
+    if (fp != NULL) {
+        fclose(fp);
+    }
     //trace.funcExit("Params::setparams", SUCCESS);
     return;
 }
@@ -62,3 +141,13 @@ void Params::setparams(char *config_file) {
 int Params::getcurrtime() {
     return globaltime;
 }
+
+/**
+ * FUNCTION NAME: zoneOf
+ *
+ * DESCRIPTION: Zone of the node with the given id. Nodes are dealt round-robin over
+ * 				ZONE_COUNT zones
+ */
+int Params::zoneOf(int id) {
+    return ZONE_COUNT > 1 ? (id - 1) % ZONE_COUNT : 0;
+}
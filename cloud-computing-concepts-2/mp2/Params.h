@@ -15,6 +15,22 @@ enum testTYPE {
     CREATE_TEST, READ_TEST, UPDATE_TEST, DELETE_TEST
 };
 
+enum seedSelection {
+    HASHED_SEED, RANDOM_SEED
+};
+
+enum failureDetector {
+    FIXED_TIMEOUT, PHI_ACCRUAL
+};
+
+enum membershipMode {
+    FULL_VIEW, PARTIAL_VIEW
+};
+
+enum placementMode {
+    RING_PLACEMENT, MAGLEV_PLACEMENT, JUMP_PLACEMENT
+};
+
 /**
  * CLASS NAME: Params
  *
@@ -34,12 +50,45 @@ public:
     int allNodesJoined;
     short PORTNUM;
     int CRUDTEST;
+    int GOSSIP_FANOUT;            // gossip targets per round, 0 adapts to log(N)
+    int JOINREP_MAX_CHUNKS;        // max JOINREP messages per joiner
+    int JOINS_PER_TICK;            // max JOINREQs an introducer answers per round
+    int JOIN_SEEDS;                // the first JOIN_SEEDS nodes act as introducers
+    int SEED_SELECTION;            // HASHED_SEED or RANDOM_SEED
+    int JOIN_TIMEOUT;            // rounds without JOINREP before trying the next seed
+    int FAILURE_DETECTOR;        // FIXED_TIMEOUT (TFAIL) or PHI_ACCRUAL
+    double PHI_THRESHOLD;        // suspicion level at which PHI_ACCRUAL suspects a member
+    int MEMBERSHIP_MODE;        // FULL_VIEW or PARTIAL_VIEW (HyParView)
+    int ACTIVE_VIEW_SIZE;        // PARTIAL_VIEW neighbours, 0 adapts to log(N)
+    int PASSIVE_VIEW_SIZE;        // PARTIAL_VIEW backup neighbours, 0 adapts to log(N)
+    int SHUFFLE_PERIOD;            // rounds between two passive view shuffles
+    int PIGGYBACK_ENTRIES;        // membership entries riding on each key-value message
+    int HEARTBEAT_SUPPRESS;        // rounds a key-value message stands in for a heartbeat
+    int ZONE_COUNT;                // failure domains, node id is in zone (id - 1) % ZONE_COUNT
+    double CROSS_ZONE_GOSSIP;    // chance a member of another zone is gossiped to when its turn comes
+    int ZONE_DELAY;                // extra rounds a message takes to cross zones
+    int LEAVE_TIME;                // round at which LEAVE_COUNT nodes leave the group
+    int LEAVE_COUNT;            // nodes leaving gracefully, the last ones still up
+    int SNAPSHOT_PERIOD;        // rounds between two snapshots of a node's store, 0 for none
+    int RESTART_TIME;            // round at which the nodes down are restarted, 0 for never
+    int VNODES;                    // tokens of each node on the ring
+    int PLACEMENT;                // RING_PLACEMENT, MAGLEV_PLACEMENT or JUMP_PLACEMENT of the replicas
+    int PLACEMENT_STATS;        // sample the replicas each membership change moves, 0 for none
+    int RANGE_TRANSFER;            // stream replica transfers in acknowledged batches, 0 for a CREATE per key
+    int PRELOAD_KEYS;            // keys written straight to their replicas before the test, to load the store
+    int ANTI_ENTROPY_PERIOD;    // rounds between two Merkle tree exchanges of a replica range, 0 for none
+    int STABILIZE_FILTER;        // offer stabilization keys against the replica's Bloom filters, 0 to send them all
+    int REBALANCE_KEYS;            // keys stabilization goes through per round, 0 for all at once
+    int REBALANCE_BYTES;        // record bytes stabilization queues per round, 0 for no limit
+    int TOMBSTONE_TTL;            // rounds a delete is remembered, beyond any outage caught up on; 0 for ever
 
     Params();
 
     void setparams(char *);
 
     int getcurrtime();
+
+    int zoneOf(int id);
 };
 
 #endif /* _PARAMS_H_ */
@@ -0,0 +1,69 @@
+/**********************************
+ * FILE NAME: RangeTransfer.cpp
+ *
+ * DESCRIPTION: TransferBatch class definition
+ **********************************/
+
+#include "RangeTransfer.h"
+
+/**
+ * FUNCTION NAME: recordSize
+ *
+ * DESCRIPTION: Returns the bytes a record takes in a batch
+ */
+size_t TransferBatch::recordSize(string_view key, string_view value) {
+    return 1 + sizeof(int64_t) + 2 * sizeof(uint16_t) + key.size() + value.size();
+}
+
+/**
+ * FUNCTION NAME: append
+ *
+ * DESCRIPTION: Append a record to batch, of a key written at round stamp. A tombstone
+ * 				carries no value
+ */
+void TransferBatch::append(string &batch, string_view key, string_view value, bool deleted, long stamp) {
+    uint16_t keySize = (uint16_t) key.size();
+    uint16_t valueSize = deleted ? 0 : (uint16_t) value.size();
+    int64_t written = stamp;
+    batch.push_back((char) deleted);
+    batch.append((const char *) &written, sizeof(written));
+    batch.append((const char *) &keySize, sizeof(keySize));
+    batch.append(key.data(), keySize);
+    batch.append((const char *) &valueSize, sizeof(valueSize));
+    batch.append(value.data(), valueSize);
+}
+
+/**
+ * FUNCTION NAME: next
+ *
+ * DESCRIPTION: Read the first record of batch, in place, and move batch past it
+ *
+ * RETURNS:
+ * false at the end of the batch, or if the record runs past it
+ */
+bool TransferBatch::next(string_view &batch, string_view &key, string_view &value, bool &deleted, long &stamp) {
+    int64_t written;
+    uint16_t keySize;
+    uint16_t valueSize;
+    if (batch.size() < 1 + sizeof(written) + sizeof(keySize)) {
+        return false;
+    }
+    deleted = batch[0] != 0;
+    memcpy(&written, batch.data() + 1, sizeof(written));
+    stamp = (long) written;
+    memcpy(&keySize, batch.data() + 1 + sizeof(written), sizeof(keySize));
+    size_t at = 1 + sizeof(written) + sizeof(keySize);
+    if (batch.size() < at + keySize + sizeof(valueSize)) {
+        return false;
+    }
+    key = batch.substr(at, keySize);
+    at += keySize;
+    memcpy(&valueSize, batch.data() + at, sizeof(valueSize));
+    at += sizeof(valueSize);
+    if (batch.size() < at + valueSize) {
+        return false;
+    }
+    value = batch.substr(at, valueSize);
+    batch.remove_prefix(at + valueSize);
+    return true;
+}
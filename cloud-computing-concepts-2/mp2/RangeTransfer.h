@@ -0,0 +1,114 @@
+/**********************************
+ * FILE NAME: RangeTransfer.h
+ *
+ * DESCRIPTION: Streams of key-value records moved between replicas
+ **********************************/
+
+#ifndef RANGETRANSFER_H_
+#define RANGETRANSFER_H_
+
+#include "stdincludes.h"
+#include "Member.h"
+#include "MembershipPiggyback.h"
+
+/**
+ * Macros
+ */
+// Batches of a stream sent and not acknowledged yet
+#define TRANSFER_WINDOW 32
+// Rounds without a new acknowledgement before the first unacknowledged batch is sent again
+#define TRANSFER_TIMEOUT 5
+// Timeouts in a row after which a stream is given up, its receiver being gone
+#define TRANSFER_RETRIES 5
+// Room left in a batch for each membership entry riding on it
+#define TRANSFER_PIGGYBACK_ROOM PIGGYBACK_ENTRY_SIZE
+
+/**
+ * STRUCT NAME: TransferKey
+ *
+ * DESCRIPTION: A key to stream, or the tombstone of a deleted one. The value of a key is
+ * 				read from the store when its batch is packed
+ */
+typedef struct TransferKey {
+    string key;
+    bool deleted;
+} TransferKey;
+
+/**
+ * Keys to stream, gathered by the node they go to
+ */
+typedef vector <pair<Address, vector <TransferKey>>> TransferQueue;
+
+/**
+ * STRUCT NAME: RangeTransfer
+ *
+ * DESCRIPTION: Sending side of a stream: the keys of a ring range for one node, in ring
+ * 				order but for those moved to the end when a resent batch outgrew a message,
+ * 				cut into batches as they are sent. Batches are numbered from 0 and
+ * 				acknowledged cumulatively; after a timeout the first batch not acknowledged
+ * 				is sent again, as the ones behind it are likely held by the receiver
+ */
+typedef struct RangeTransfer {
+    Address to;
+    vector <TransferKey> keys;
+    // First key of every batch packed so far, then the key after the last one
+    vector <size_t> batchStart;
+    // Batches acknowledged, and batches sent
+    uint32_t acked;
+    uint32_t next;
+    int started;
+    int lastProgress;
+    int timeouts;
+} RangeTransfer;
+
+/**
+ * STRUCT NAME: TransferReceipt
+ *
+ * DESCRIPTION: Receiving side of a stream. The network does not keep messages in order,
+ * 				and every key is in one batch only, so batches are applied as they come;
+ * 				those past the first gap are remembered until it is filled
+ */
+typedef struct TransferReceipt {
+    // Batches up to the first one missing, and the ones applied after it
+    uint32_t received;
+    set <uint32_t> ahead;
+    int lastSeen;
+} TransferReceipt;
+
+/**
+ * STRUCT NAME: TransferStats
+ *
+ * DESCRIPTION: Replica transfers sent by one or more nodes
+ */
+typedef struct TransferStats {
+    long records;
+    long messages;
+    // batches sent again after a timeout, and messages the network refused at its buffer cap
+    long resent;
+    long dropped;
+    long bytes;
+    long streams;
+    long completed;
+    long abandoned;
+    // rounds from the start of the completed streams to their last acknowledgement
+    long rounds;
+} TransferStats;
+
+/**
+ * CLASS NAME: TransferBatch
+ *
+ * DESCRIPTION: Packing of the records of a TRANSFER message: for each, a byte telling a
+ * 				tombstone, the round the key was written at as an int64, then the key and
+ * 				the value, each as a uint16 length followed by its bytes. Host byte order,
+ * 				as the rest of the binary form
+ */
+class TransferBatch {
+public:
+    static size_t recordSize(string_view key, string_view value);
+
+    static void append(string &batch, string_view key, string_view value, bool deleted, long stamp);
+
+    static bool next(string_view &batch, string_view &key, string_view &value, bool &deleted, long &stamp);
+};
+
+#endif /* RANGETRANSFER_H_ */
@@ -0,0 +1,190 @@
+/**********************************
+ * FILE NAME: RingDigest.cpp
+ *
+ * DESCRIPTION: RingDigest class definition
+ **********************************/
+
+#include "RingDigest.h"
+
+/**
+ * Constructor
+ */
+RingDigest::RingDigest() : epoch(0), checksum(0), aliveCount(0) {}
+
+/**
+ * Destructor
+ */
+RingDigest::~RingDigest() {}
+
+/**
+ * FUNCTION NAME: key
+ *
+ * DESCRIPTION: Sort key of a member
+ */
+long RingDigest::key(int id, short port) {
+    return ((long) id << 16) | (unsigned short) port;
+}
+
+/**
+ * FUNCTION NAME: entryHash
+ *
+ * DESCRIPTION: splitmix64 of an entry, xor-ed into the checksum
+ */
+unsigned long long RingDigest::entryHash(const RingEntry &entry) {
+    unsigned long long z = ((unsigned long long) key(entry.id, entry.port) << 2 | entry.state) ^
+                           ((unsigned long long) entry.version << 32);
+    z += 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * FUNCTION NAME: position
+ *
+ * DESCRIPTION: Returns where the entry of a member is, or would be inserted
+ */
+vector<RingEntry>::iterator RingDigest::position(int id, short port) {
+    long k = key(id, port);
+    return std::lower_bound(entries.begin(), entries.end(), k, [](const RingEntry &entry, long k) {
+        return key(entry.id, entry.port) < k;
+    });
+}
+
+/**
+ * FUNCTION NAME: merge
+ *
+ * DESCRIPTION: Take in an entry received from another node. The newer version wins; of
+ * 				two entries with the same version the one not alive does.
+ *
+ * RETURNS:
+ * true if the digest changed, with previous holding the replaced entry (RING_UNKNOWN for
+ * a member that was not known)
+ */
+bool RingDigest::merge(const RingEntry &entry, RingEntry &previous) {
+    vector<RingEntry>::iterator it = position(entry.id, entry.port);
+    epoch = std::max(epoch, entry.version);
+    if (it != entries.end() && it->id == entry.id && it->port == entry.port) {
+        if (entry.version < it->version ||
+            (entry.version == it->version && (entry.state == it->state || entry.state == RING_ALIVE))) {
+            return false;
+        }
+        previous = *it;
+        checksum ^= entryHash(*it);
+        aliveCount -= it->state == RING_ALIVE;
+        *it = entry;
+    } else {
+        previous = entry;
+        previous.state = RING_UNKNOWN;
+        it = entries.insert(it, entry);
+    }
+    checksum ^= entryHash(*it);
+    aliveCount += it->state == RING_ALIVE;
+    return true;
+}
+
+/**
+ * FUNCTION NAME: announce
+ *
+ * DESCRIPTION: Record a local decision about a member, versioned past everything seen
+ *
+ * RETURNS:
+ * the new entry, to be spread to the other nodes
+ */
+RingEntry RingDigest::announce(int id, short port, RingState state) {
+    RingEntry entry;
+    entry.id = id;
+    entry.port = port;
+    entry.state = state;
+    entry.version = epoch + 1;
+    RingEntry previous;
+    merge(entry, previous);
+    return entry;
+}
+
+/**
+ * FUNCTION NAME: find
+ *
+ * DESCRIPTION: Returns the entry of a member, NULL if it is not known
+ */
+const RingEntry *RingDigest::find(int id, short port) {
+    vector<RingEntry>::iterator it = position(id, port);
+    if (it == entries.end() || it->id != id || it->port != port) {
+        return NULL;
+    }
+    return &*it;
+}
+
+/**
+ * FUNCTION NAME: since
+ *
+ * DESCRIPTION: Append the entries decided after epoch from to out. A negative from
+ * 				returns the whole digest.
+ */
+void RingDigest::since(long from, vector <RingEntry> &out) {
+    std::for_each(entries.begin(), entries.end(), [from, &out](const RingEntry &entry) {
+        if (entry.version > from) {
+            out.push_back(entry);
+        }
+    });
+}
+
+/**
+ * FUNCTION NAME: at
+ *
+ * DESCRIPTION: Returns the i-th entry in member order
+ */
+const RingEntry &RingDigest::at(size_t i) {
+    return entries[i];
+}
+
+/**
+ * FUNCTION NAME: summary
+ *
+ * DESCRIPTION: Returns the epoch and checksum of the digest
+ */
+DigestSummary RingDigest::summary() {
+    DigestSummary summary;
+    summary.epoch = epoch;
+    summary.checksum = checksum;
+    return summary;
+}
+
+/**
+ * FUNCTION NAME: getEpoch
+ *
+ * DESCRIPTION: Returns the newest version known
+ */
+long RingDigest::getEpoch() {
+    return epoch;
+}
+
+/**
+ * FUNCTION NAME: size
+ *
+ * DESCRIPTION: Returns the number of entries, dead ones included
+ */
+size_t RingDigest::size() {
+    return entries.size();
+}
+
+/**
+ * FUNCTION NAME: alive
+ *
+ * DESCRIPTION: Returns the number of members in the ring
+ */
+size_t RingDigest::alive() {
+    return aliveCount;
+}
+
+/**
+ * FUNCTION NAME: clear
+ *
+ * DESCRIPTION: Forget every member
+ */
+void RingDigest::clear() {
+    entries.clear();
+    epoch = 0;
+    checksum = 0;
+    aliveCount = 0;
+}
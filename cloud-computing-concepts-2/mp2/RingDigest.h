@@ -0,0 +1,95 @@
+/**********************************
+ * FILE NAME: RingDigest.h
+ *
+ * DESCRIPTION: Header file of RingDigest class
+ **********************************/
+
+#ifndef RINGDIGEST_H_
+#define RINGDIGEST_H_
+
+#include "stdincludes.h"
+
+/**
+ * State of a member in the ring digest. A member that is not known has RING_UNKNOWN
+ */
+enum RingState {
+    RING_UNKNOWN = -1,
+    RING_FAILED,
+    RING_ALIVE,
+    RING_LEFT
+};
+
+/**
+ * STRUCT NAME: RingEntry
+ *
+ * DESCRIPTION: Whether a member is in the ring, failed or left, and the digest epoch at
+ * 				which that was last decided
+ */
+typedef struct RingEntry {
+    int id;
+    short port;
+    short state;
+    long version;
+} RingEntry;
+
+/**
+ * STRUCT NAME: DigestSummary
+ *
+ * DESCRIPTION: What two nodes compare to tell whether their digests differ
+ */
+typedef struct DigestSummary {
+    long epoch;
+    unsigned long long checksum;
+} DigestSummary;
+
+/**
+ * CLASS NAME: RingDigest
+ *
+ * DESCRIPTION: Compact, epoch-versioned list of the members of the ring, used when the
+ * 				membership protocol only keeps a partial view of the group. Entries are kept
+ * 				sorted by member and are never deleted; a member that failed or left stays
+ * 				as a dead entry so that this is not undone by an older copy. The epoch is a
+ * 				Lamport clock: a local change is versioned one past the epoch, and merging
+ * 				moves the epoch up to the newest version seen. The checksum is an order
+ * 				independent hash of all entries, updated incrementally.
+ */
+class RingDigest {
+private:
+    vector <RingEntry> entries;
+    long epoch;
+    unsigned long long checksum;
+    size_t aliveCount;
+
+    static long key(int id, short port);
+
+    static unsigned long long entryHash(const RingEntry &entry);
+
+    vector<RingEntry>::iterator position(int id, short port);
+
+public:
+    RingDigest();
+
+    bool merge(const RingEntry &entry, RingEntry &previous);
+
+    RingEntry announce(int id, short port, RingState state);
+
+    const RingEntry *find(int id, short port);
+
+    void since(long from, vector <RingEntry> &out);
+
+    const RingEntry &at(size_t i);
+
+    DigestSummary summary();
+
+    long getEpoch();
+
+    size_t size();
+
+    size_t alive();
+
+    void clear();
+
+    virtual ~RingDigest();
+};
+
+#endif /* RINGDIGEST_H_ */
@@ -0,0 +1,184 @@
+/**********************************
+ * FILE NAME: StringArena.cpp
+ *
+ * DESCRIPTION: StringArena class definition
+ **********************************/
+
+#include "StringArena.h"
+
+/**
+ * Constructor
+ */
+StringArena::StringArena(size_t firstChunk) {
+    top = NULL;
+    room = 0;
+    nextChunk = std::min(std::max(firstChunk, (size_t) ARENA_FIRST_CHUNK), (size_t) ARENA_MAX_CHUNK);
+    std::fill(freeLists, freeLists + ARENA_CLASSES, (char *) NULL);
+    reserved = 0;
+    allocated = 0;
+    live = 0;
+}
+
+/**
+ * Destructor
+ */
+StringArena::~StringArena() {
+    std::for_each(chunks.begin(), chunks.end(), [](char *chunk) {
+        free(chunk);
+    });
+}
+
+/**
+ * FUNCTION NAME: classOf
+ *
+ * DESCRIPTION: Returns the size class of a block of size bytes
+ */
+int StringArena::classOf(size_t size) {
+    int sizeClass = 0;
+    while (((size_t) ARENA_MIN_CLASS << sizeClass) < size) {
+        sizeClass++;
+    }
+    return sizeClass;
+}
+
+/**
+ * FUNCTION NAME: push
+ *
+ * DESCRIPTION: Put a free block on the free list of its class
+ */
+void StringArena::push(char *block, int sizeClass) {
+    memcpy(block, &freeLists[sizeClass], sizeof(char *));
+    freeLists[sizeClass] = block;
+}
+
+/**
+ * FUNCTION NAME: newChunk
+ *
+ * DESCRIPTION: Start a chunk of at least size bytes. The end of the current one is cut
+ * 				into the largest blocks that fit and put on the free lists
+ */
+void StringArena::newChunk(size_t size) {
+    while (room >= ARENA_MIN_CLASS) {
+        int sizeClass = classOf(room + 1) - 1;
+        size_t bytes = (size_t) ARENA_MIN_CLASS << sizeClass;
+        push(top, sizeClass);
+        top += bytes;
+        room -= bytes;
+    }
+    size_t bytes = std::max(nextChunk, size);
+    top = (char *) malloc(bytes);
+    room = bytes;
+    chunks.push_back(top);
+    reserved += bytes;
+    nextChunk = std::min(nextChunk * 2, (size_t) ARENA_MAX_CHUNK);
+}
+
+/**
+ * FUNCTION NAME: store
+ *
+ * DESCRIPTION: Copy bytes into the arena
+ *
+ * RETURNS:
+ * the copy, valid until it is released or the arena is dropped; NULL for no bytes
+ */
+char *StringArena::store(string_view bytes) {
+    if (bytes.empty()) {
+        return NULL;
+    }
+    int sizeClass = classOf(bytes.size());
+    // Strings come off messages, whose fields are below ARENA_MAX_CHUNK
+    assert(sizeClass < ARENA_CLASSES);
+    size_t size = (size_t) ARENA_MIN_CLASS << sizeClass;
+    char *block = freeLists[sizeClass];
+    if (block) {
+        memcpy(&freeLists[sizeClass], block, sizeof(char *));
+    } else {
+        if (room < size) {
+            newChunk(size);
+        }
+        block = top;
+        top += size;
+        room -= size;
+    }
+    memcpy(block, bytes.data(), bytes.size());
+    allocated += size;
+    live += bytes.size();
+    return block;
+}
+
+/**
+ * FUNCTION NAME: release
+ *
+ * DESCRIPTION: Give back the block of a string of size bytes returned by store
+ */
+void StringArena::release(char *data, size_t size) {
+    if (data == NULL) {
+        return;
+    }
+    int sizeClass = classOf(size);
+    push(data, sizeClass);
+    allocated -= (size_t) ARENA_MIN_CLASS << sizeClass;
+    live -= size;
+}
+
+/**
+ * FUNCTION NAME: replace
+ *
+ * DESCRIPTION: Replace a string of size bytes returned by store with bytes, in place when
+ * 				both fall in the same size class
+ *
+ * RETURNS:
+ * the new copy
+ */
+char *StringArena::replace(char *data, size_t size, string_view bytes) {
+    if (data == NULL || bytes.empty() || classOf(size) != classOf(bytes.size())) {
+        release(data, size);
+        return store(bytes);
+    }
+    memcpy(data, bytes.data(), bytes.size());
+    live = live - size + bytes.size();
+    return data;
+}
+
+/**
+ * FUNCTION NAME: swap
+ *
+ * DESCRIPTION: Exchange the contents of two arenas
+ */
+void StringArena::swap(StringArena &other) {
+    chunks.swap(other.chunks);
+    std::swap(top, other.top);
+    std::swap(room, other.room);
+    std::swap(nextChunk, other.nextChunk);
+    std::swap_ranges(freeLists, freeLists + ARENA_CLASSES, other.freeLists);
+    std::swap(reserved, other.reserved);
+    std::swap(allocated, other.allocated);
+    std::swap(live, other.live);
+}
+
+/**
+ * FUNCTION NAME: reservedBytes
+ *
+ * DESCRIPTION: Returns the bytes of all chunks
+ */
+size_t StringArena::reservedBytes() const {
+    return reserved;
+}
+
+/**
+ * FUNCTION NAME: allocatedBytes
+ *
+ * DESCRIPTION: Returns the bytes of the blocks in use, rounded up to their size classes
+ */
+size_t StringArena::allocatedBytes() const {
+    return allocated;
+}
+
+/**
+ * FUNCTION NAME: liveBytes
+ *
+ * DESCRIPTION: Returns the bytes of the strings in use
+ */
+size_t StringArena::liveBytes() const {
+    return live;
+}
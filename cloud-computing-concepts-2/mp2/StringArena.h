@@ -0,0 +1,75 @@
+/**********************************
+ * FILE NAME: StringArena.h
+ *
+ * DESCRIPTION: Header file of StringArena class
+ **********************************/
+
+#ifndef STRINGARENA_H_
+#define STRINGARENA_H_
+
+#include "stdincludes.h"
+
+/**
+ * Macros
+ */
+// Size classes are the powers of two from 8 bytes to ARENA_MAX_CHUNK
+#define ARENA_MIN_CLASS 8
+#define ARENA_CLASSES 14
+// Chunks start small, so that a node holding a few keys reserves little, and double
+#define ARENA_FIRST_CHUNK 1024
+#define ARENA_MAX_CHUNK 65536
+
+/**
+ * CLASS NAME: StringArena
+ *
+ * DESCRIPTION: Bump allocator for the bytes of keys and values. Every allocation is
+ * 				rounded up to its size class and carved from the current chunk; released
+ * 				blocks go to the free list of their class and are handed out again before
+ * 				the chunk is bumped. Chunks are only given back when the arena is dropped,
+ * 				so its owner compacts it into a fresh one when most of it is free.
+ */
+class StringArena {
+private:
+    vector<char *> chunks;
+    // Unused end of the current chunk
+    char *top;
+    size_t room;
+    size_t nextChunk;
+    // Heads of the free lists, linked through the first bytes of the free blocks
+    char *freeLists[ARENA_CLASSES];
+    // Bytes of the chunks, of the blocks handed out, and asked for
+    size_t reserved;
+    size_t allocated;
+    size_t live;
+
+    static int classOf(size_t size);
+
+    void push(char *block, int sizeClass);
+
+    void newChunk(size_t size);
+
+public:
+    StringArena(size_t firstChunk = ARENA_FIRST_CHUNK);
+
+    StringArena(const StringArena &) = delete;
+
+    StringArena &operator=(const StringArena &) = delete;
+
+    char *store(string_view bytes);
+
+    void release(char *data, size_t size);
+
+    char *replace(char *data, size_t size, string_view bytes);
+
+    void swap(StringArena &other);
+
+    size_t reservedBytes() const;
+
+    size_t allocatedBytes() const;
+
+    size_t liveBytes() const;
+
+    virtual ~StringArena();
+};
+
+#endif /* STRINGARENA_H_ */
@@ -0,0 +1,86 @@
+/**********************************
+ * FILE NAME: TimerWheel.cpp
+ *
+ * DESCRIPTION: TimerWheel class definition
+ **********************************/
+
+#include "TimerWheel.h"
+
+/**
+ * Constructor
+ */
+TimerWheel::TimerWheel() : slots(WHEEL_SLOTS), current(-1), pending(0) {}
+
+/**
+ * Destructor
+ */
+TimerWheel::~TimerWheel() {}
+
+/**
+ * FUNCTION NAME: schedule
+ *
+ * DESCRIPTION: Arm a timer for key at deadline. A deadline that has already been
+ * 				processed fires on the next call to advance.
+ */
+void TimerWheel::schedule(long key, long deadline) {
+    Timer timer;
+    timer.key = key;
+    timer.deadline = deadline;
+
+    long tick = deadline > current ? deadline : current + 1;
+    slots[tick & (WHEEL_SLOTS - 1)].push_back(timer);
+    pending++;
+}
+
+/**
+ * FUNCTION NAME: advance
+ *
+ * DESCRIPTION: Move the wheel forward to now and append every timer whose deadline
+ * 				is at or before now to due. Timers that hash to a visited slot but belong
+ * 				to a later revolution stay in the wheel.
+ */
+void TimerWheel::advance(long now, vector <Timer> &due) {
+    long ticks = now - current;
+    if (ticks <= 0) {
+        return;
+    }
+    if (ticks > WHEEL_SLOTS) {
+        ticks = WHEEL_SLOTS;
+    }
+
+    for (long tick = now - ticks + 1; tick <= now; tick++) {
+        vector <Timer> &slot = slots[tick & (WHEEL_SLOTS - 1)];
+        size_t kept = 0;
+        for (size_t i = 0; i < slot.size(); i++) {
+            if (slot[i].deadline <= now) {
+                due.push_back(slot[i]);
+                pending--;
+            } else {
+                slot[kept++] = slot[i];
+            }
+        }
+        slot.resize(kept);
+    }
+    current = now;
+}
+
+/**
+ * FUNCTION NAME: size
+ *
+ * DESCRIPTION: Returns the number of timers held by the wheel
+ */
+size_t TimerWheel::size() {
+    return pending;
+}
+
+/**
+ * FUNCTION NAME: clear
+ *
+ * DESCRIPTION: Drop all timers
+ */
+void TimerWheel::clear() {
+    for (size_t i = 0; i < slots.size(); i++) {
+        slots[i].clear();
+    }
+    pending = 0;
+}
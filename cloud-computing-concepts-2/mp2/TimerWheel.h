@@ -0,0 +1,58 @@
+/**********************************
+ * FILE NAME: TimerWheel.h
+ *
+ * DESCRIPTION: Header file of TimerWheel class
+ **********************************/
+
+#ifndef TIMERWHEEL_H_
+#define TIMERWHEEL_H_
+
+#include "stdincludes.h"
+
+/**
+ * Macros
+ */
+// Number of slots in the wheel, must be a power of two
+#define WHEEL_SLOTS 64
+
+/**
+ * STRUCT NAME: Timer
+ *
+ * DESCRIPTION: A deadline armed for a key
+ */
+typedef struct Timer {
+    long key;
+    long deadline;
+} Timer;
+
+/**
+ * CLASS NAME: TimerWheel
+ *
+ * DESCRIPTION: Hashed timing wheel. Timers are bucketed by deadline modulo the number
+ * 				of slots, so advancing the clock by one tick only visits the timers that
+ * 				hash to that tick. Timers are never cancelled; owners keep the deadline
+ * 				they last armed and ignore timers that do not match it.
+ */
+class TimerWheel {
+private:
+    vector <vector<Timer>> slots;
+    // Last tick that has been processed
+    long current;
+    // Number of timers in the wheel, including stale ones
+    size_t pending;
+
+public:
+    TimerWheel();
+
+    void schedule(long key, long deadline);
+
+    void advance(long now, vector <Timer> &due);
+
+    size_t size();
+
+    void clear();
+
+    virtual ~TimerWheel();
+};
+
+#endif /* TIMERWHEEL_H_ */
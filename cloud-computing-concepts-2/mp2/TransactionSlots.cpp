@@ -0,0 +1,117 @@
+/**********************************
+ * FILE NAME: TransactionSlots.cpp
+ *
+ * DESCRIPTION: TransactionSlots class definition
+ **********************************/
+
+#include "TransactionSlots.h"
+
+/**
+ * Constructor
+ */
+TransactionSlots::TransactionSlots() {
+    clear();
+}
+
+/**
+ * Destructor
+ */
+TransactionSlots::~TransactionSlots() {}
+
+/**
+ * FUNCTION NAME: slotOf
+ *
+ * DESCRIPTION: Returns the slot of transID
+ */
+size_t TransactionSlots::slotOf(int transID) const {
+    return (size_t) (unsigned int) transID & (slots.size() - 1);
+}
+
+/**
+ * FUNCTION NAME: grow
+ *
+ * DESCRIPTION: Double the table, moving the live transactions to their new slots, until
+ * 				no two of them share one
+ */
+void TransactionSlots::grow() {
+    vector <TransactionSlot> old;
+    old.swap(slots);
+    size_t size = old.size();
+    bool shared = true;
+    while (shared) {
+        size *= 2;
+        slots.assign(size, TransactionSlot{0, false, Transaction()});
+        shared = false;
+        for (size_t i = 0; i < old.size() && !shared; i++) {
+            if (old[i].live) {
+                shared = slots[slotOf(old[i].transID)].live;
+                slots[slotOf(old[i].transID)].live = true;
+            }
+        }
+    }
+    for (size_t i = 0; i < old.size(); i++) {
+        if (old[i].live) {
+            slots[slotOf(old[i].transID)] = std::move(old[i]);
+        }
+    }
+}
+
+/**
+ * FUNCTION NAME: insert
+ *
+ * DESCRIPTION: Store transaction under transID, which must not be live, and return it
+ */
+Transaction &TransactionSlots::insert(int transID, Transaction &&transaction) {
+    while (slots[slotOf(transID)].live) {
+        grow();
+    }
+    TransactionSlot &slot = slots[slotOf(transID)];
+    slot.transID = transID;
+    slot.live = true;
+    slot.transaction = std::move(transaction);
+    live++;
+    return slot.transaction;
+}
+
+/**
+ * FUNCTION NAME: find
+ *
+ * DESCRIPTION: Returns the live transaction of transID, NULL if there is none
+ */
+Transaction *TransactionSlots::find(int transID) {
+    TransactionSlot &slot = slots[slotOf(transID)];
+    return slot.live && slot.transID == transID ? &slot.transaction : NULL;
+}
+
+/**
+ * FUNCTION NAME: erase
+ *
+ * DESCRIPTION: Drop the transaction of transID, if live
+ */
+void TransactionSlots::erase(int transID) {
+    TransactionSlot &slot = slots[slotOf(transID)];
+    if (slot.live && slot.transID == transID) {
+        slot.live = false;
+        slot.transaction = Transaction();
+        live--;
+    }
+}
+
+/**
+ * FUNCTION NAME: size
+ *
+ * DESCRIPTION: Returns the number of live transactions
+ */
+size_t TransactionSlots::size() {
+    return live;
+}
+
+/**
+ * FUNCTION NAME: clear
+ *
+ * DESCRIPTION: Drop every transaction and shrink the table back
+ */
+void TransactionSlots::clear() {
+    slots.assign(TRANSACTION_SLOTS, TransactionSlot{0, false, Transaction()});
+    live = 0;
+}
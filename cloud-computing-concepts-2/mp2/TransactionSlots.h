@@ -0,0 +1,70 @@
+/**********************************
+ * FILE NAME: TransactionSlots.h
+ *
+ * DESCRIPTION: Header file of TransactionSlots class
+ **********************************/
+
+#ifndef TRANSACTIONSLOTS_H_
+#define TRANSACTIONSLOTS_H_
+
+#include "stdincludes.h"
+
+/**
+ * Macros
+ */
+// Slots of an empty table, a power of two
+#define TRANSACTION_SLOTS 64
+
+struct Transaction {
+    int timestamp;
+    string request;
+    // values of the replies received, empty but for read replies
+    vector<string> responses;
+};
+
+/**
+ * STRUCT NAME: TransactionSlot
+ *
+ * DESCRIPTION: A slot of the table, and the transaction in it if live
+ */
+typedef struct TransactionSlot {
+    int transID;
+    bool live;
+    Transaction transaction;
+} TransactionSlot;
+
+/**
+ * CLASS NAME: TransactionSlots
+ *
+ * DESCRIPTION: Transactions a coordinator waits on, by transID. A transaction lives in the
+ * 				slot of its transID modulo the size of the table, a power of two, so a
+ * 				reply finds it without a search. transIDs are handed out in order and a
+ * 				transaction lives a few rounds, so the live ones rarely share a slot; the
+ * 				table doubles until they do not.
+ */
+class TransactionSlots {
+private:
+    vector <TransactionSlot> slots;
+    size_t live;
+
+    size_t slotOf(int transID) const;
+
+    void grow();
+
+public:
+    TransactionSlots();
+
+    Transaction &insert(int transID, Transaction &&transaction);
+
+    Transaction *find(int transID);
+
+    void erase(int transID);
+
+    size_t size();
+
+    void clear();
+
+    virtual ~TransactionSlots();
+};
+
+#endif /* TRANSACTIONSLOTS_H_ */
@@ -9,7 +9,8 @@ static int g_transID = 0;
 
 // message types, reply is the message from node to coordinator
 enum MessageType {
-    CREATE, READ, UPDATE, DELETE, REPLY, READREPLY
+    CREATE, READ, UPDATE, DELETE, REPLY, READREPLY, CATCHUP, TRANSFER, TRANSFERACK, MERKLE, MERKLEKEYS, MERKLEPULL,
+    FILTERREQ, FILTERREP, CONFIRMREQ, CONFIRMREP
 };
 // enum of replica types
 enum ReplicaType {
@@ -10,7 +10,6 @@
 /*
  * Macros
  */
-#define RING_SIZE 512
 #define FAILURE -1
 #define SUCCESS 0
 
@@ -21,6 +20,8 @@
 #include <math.h>
 #include <string.h>
 #include <stdlib.h>
+#include <limits.h>
+#include <stdint.h>
 #include <assert.h>
 #include <time.h>
 #include <stdarg.h>
@@ -31,10 +32,18 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <string>
+#include <string_view>
+#include <charconv>
 #include <algorithm>
+#include <functional>
 #include <queue>
 #include <fstream>
+#include <random>
+#include <chrono>
 
 using namespace std;
 